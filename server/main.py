@@ -157,6 +157,7 @@ async def solve(data: dict):
         "-f", em_file_path,
         "-g", geojson_file_path,
         "-i", "5000",
+        "--time-limit", "50", # Below the timeout, so the best solution found is returned
         "-o", "json"
     ]
 
@@ -0,0 +1,85 @@
+#pragma once
+#ifndef ANNEALING_OPTIMIZER_HPP
+#define ANNEALING_OPTIMIZER_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include "global.hpp"
+#include "optimizer.hpp"
+#include "network.hpp"
+#include "coverage.hpp"
+#include "coverage_matrix.hpp"
+
+/**
+ *
+ * @brief Simulated annealing over candidate sites for the Gateway Placement Problem.
+ *
+ * A move adds, removes or relocates one gateway. Each end device caches its best and second
+ * best gateway, so the cost change of a move only visits the devices in range of the sites
+ * involved, without connecting the whole network. The cost is optimizer::deviceCost(): gateways,
+ * a penalty per unconnected end device and a small weight on the distances.
+ * Gateways already in the network are kept fixed.
+ *
+ */
+
+#define ANNEALING_MOVES 1000000 // Moves per run
+#define ANNEALING_INITIAL_TEMPERATURE 2.0 // Gateway units
+#define ANNEALING_FINAL_TEMPERATURE 0.01
+#define ANNEALING_TELEMETRY_INTERVAL 10000 // Moves between telemetry samples
+#define ANNEALING_DEADLINE_INTERVAL 1024 // Moves between time limit checks
+
+class AnnealingOptimizer : public optimizer::Optimizer {
+public:
+    AnnealingOptimizer(network::Network& net,
+                       double spacing = CANDIDATE_SITE_SPACING,
+                       double height = CANDIDATE_SITE_HEIGHT)
+        : optimizer::Optimizer(net), gen(rng::stream(0)), spacing(spacing), height(height) {};
+
+    void optimize(unsigned long moves);
+    void optimize() override { optimize(ANNEALING_MOVES); };
+
+    inline void setCoverageFile(const std::string& filepath) { coverage_file = filepath; };
+
+    inline unsigned long getAcceptedMoves() const { return accepted; };
+
+private:
+    static constexpr std::size_t NONE = SIZE_MAX;
+
+    rng::Philox gen;
+    double spacing;
+    double height;
+    std::string coverage_file;
+
+    coverage::CoverageMatrix matrix;
+    coverage::SiteLinks site_devices; // Devices in range of each site, with distance
+    std::vector<std::vector<std::size_t>> device_sites; // Sites in range of each device
+
+    // State
+    std::vector<std::size_t> active; // Sites with a gateway
+    std::vector<char> used; // Per site
+    std::vector<double> fixed_dist; // Distance to the gateways of the input network, infinity if none
+    std::vector<std::size_t> best_site, second_site; // Per device, among the active sites
+    std::vector<double> best_dist, second_dist;
+    std::size_t connected = 0;
+    double total_distance = 0.0;
+    double cost = 0.0;
+
+    // Scratch of the move evaluation
+    std::vector<std::uint32_t> mark;
+    std::vector<double> added_dist;
+    std::uint32_t stamp = 0;
+    long pending_connected = 0;
+    double pending_distance = 0.0;
+
+    unsigned long accepted = 0;
+
+    double siteDistance(std::size_t s, std::size_t e) const;
+    double delta(std::size_t removed, std::size_t added);
+    void apply(std::size_t removed, std::size_t added);
+    void rescan(std::size_t e); // Best and second best from scratch
+    std::size_t siteForUnconnected();
+    std::size_t siteNear(std::size_t s);
+};
+
+#endif // ANNEALING_OPTIMIZER_HPP
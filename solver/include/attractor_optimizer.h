@@ -2,10 +2,13 @@
 #define ATTRACTOR_OPTIMIZER_H
 
 #include <vector>
+#include <memory>
 #include <cmath>
+#include <cstdint>
 #include "global.hpp"
 #include "optimizer.hpp"
 #include "network.hpp"
+#include "coverage_matrix.hpp"
 
 /**
  * 
@@ -16,16 +19,84 @@
 #define STAGNATION_THRESHOLD 0.01
 #define STAGNATION_PATIENCE 10 // Iterations to wait before adding gateway
 #define MAX_GATEWAYS_TO_ADD 10 // Prevent infinite gateway addition
+#define CHECKPOINT_INTERVAL 100 // Iterations between checkpoints
+#define INITIAL_GATEWAY_HEIGHT 10.0 // Antenna height of the gateways placed by clustering (meters)
+#define SNAP_RETRIES 8 // Random positions tried for the initial gateway when it cannot be snapped to a permitted site
+#define FORCE_GATEWAY_BLOCK 4 // Gateways per pass of the blocked force kernel
+#define FORCE_DEVICE_TILE 2048 // End devices per tile of the blocked force kernel (kept in L1 for the gateways of a block)
+
+// Initial gateways: one at random, or a full set from clustering the unconnected end devices
+enum INITIALIZATION { RANDOM_INIT, KMEANS_INIT, KMEDOIDS_INIT };
+
+// Force on the gateways: from per gateway counts and sums of positions (O(E + G)), sum over every end device, 
+// or the same sum over contiguous arrays of positions and assignments (same result up to rounding)
+enum FORCE_MODE { AGGREGATED_FORCE, EXACT_FORCE, BLOCKED_FORCE };
 
 class AttractorOptimizer : public optimizer::Optimizer {
 public:
-    AttractorOptimizer(network::Network& net) : optimizer::Optimizer(net) {};
+    AttractorOptimizer(network::Network& net) : optimizer::Optimizer(net), gen(rng::stream(0)) {};
+    AttractorOptimizer(network::Network& net, rng::Philox gen) : optimizer::Optimizer(net), gen(gen) {};
 
     void optimize(unsigned int maxIterations = 500);
     void optimize() override { optimize(500); };
+
+    // Step-wise execution: optimize() is start(), step() until it returns false, and finish()
+    void start(unsigned int maxIterations = 500); // Adds the initial gateway
+    bool step(); // Runs one iteration, returns false when the optimization has finished
+    void finish(); // Restores the best connected state seen, if the last one is worse
+    inline unsigned int getIteration() const { return iteration; };
+    // Best score seen so far (the one finish() restores), the current one before the first step
+    inline optimizer::Score getBestScore() const { return best_state ? best_score : optimizer::Score::of(network); };
+    // Stops a run from outside (step() returns false), finish() still restores its best state
+    inline void discard() { stop_reason = optimizer::DISCARDED; };
+
+    inline void setInitialization(INITIALIZATION init) { initialization = init; };
+    inline void setForceMode(FORCE_MODE mode) { force_mode = mode; };
+    // Coverage matrix cache used by the k-medoids initialization
+    inline void setCoverageFile(const std::string& filepath) { coverage_file = filepath; };
+    // Coverage matrix of the candidate sites of the network for the k-medoids initialization, so concurrent runs
+    // of the same network share one (built or loaded from the coverage file by start() otherwise)
+    inline void setCoverageMatrix(std::shared_ptr<const coverage::CoverageMatrix> matrix) { coverage_matrix = std::move(matrix); };
+    // Debug output of the run (global::dbg by default), concurrent runs need their own stream
+    inline void setLog(std::ostream& stream) { log = &stream; };
+
+    // Binary checkpoint of the run (gateways, counters, random streams and best state), 
+    // written every interval iterations and when the run stops
+    inline void setCheckpoint(const std::string& filepath, unsigned int interval = CHECKPOINT_INTERVAL) { 
+        checkpoint_file = filepath; 
+        checkpoint_interval = interval; 
+    };
+    void saveCheckpoint(const std::string& filepath) const;
+    // Replaces start() to continue a run of the same network from a checkpoint, with a new iteration limit
+    void resume(const std::string& filepath, unsigned int maxIterations);
 private:
+    rng::Philox gen; // Own stream, so several optimizers can run concurrently
+    std::ostream* log = &global::dbg;
+    INITIALIZATION initialization = RANDOM_INIT;
+    FORCE_MODE force_mode = AGGREGATED_FORCE;
+    std::string coverage_file;
+    std::shared_ptr<const coverage::CoverageMatrix> coverage_matrix;
+    std::string checkpoint_file;
+    unsigned int checkpoint_interval = CHECKPOINT_INTERVAL;
+
+    unsigned int max_iterations = 500;
+    unsigned int iteration = 0;
+    int stagnant_iterations = 0;
+    int gateways_added = 0;
+
+    // Blocked force kernel: positions of the end devices (they do not move) and index of their gateways (-1 if not connected)
+    std::vector<double> ed_lat, ed_lng;
+    std::vector<std::int32_t> assignment;
+
+    std::unique_ptr<network::Network> best_state; // Copy of the network when it was connected with the best score
+    optimizer::Score best_score;
+
+    terrain::LatLngAlt randomPosition();
+    std::vector<terrain::LatLngAlt> clusterPositions(); // Sorted by unconnected end devices in range, most first
+    void aggregatedForces(std::size_t nced, std::vector<terrain::LatLngAlt>& forces) const;
+    void blockedForces(std::size_t nced, std::vector<terrain::LatLngAlt>& forces);
     terrain::LatLngAlt findOptimalGatewayPosition();
     terrain::LatLngAlt findMaxDensityPosition();
 };
 
-#endif // ATTRACTOR_OPTIMIZER_H
\ No newline at end of file
+#endif // ATTRACTOR_OPTIMIZER_H
@@ -0,0 +1,49 @@
+#pragma once
+#ifndef CLUSTERING_HPP
+#define CLUSTERING_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include "global.hpp"
+#include "terrain.hpp"
+#include "network.hpp"
+#include "coverage_matrix.hpp"
+
+/**
+ *
+ * @brief Clustering of end device positions to seed a full set of gateways.
+ *
+ * Distances are measured on a local planar projection around the mean of the points, which
+ * is accurate at the scale of a network. Assignment steps run in parallel over points, the
+ * centers are accumulated in order so results do not depend on the number of threads.
+ *
+ */
+
+#define CLUSTERING_ITERATIONS 100 // Max Lloyd (or Voronoi) iterations
+
+namespace clustering {
+
+// Lloyd k-means with k-means++ seeding. Returns min(k, points) centers (altitude is the mean of the cluster)
+std::vector<terrain::LatLngAlt> kMeans(const std::vector<terrain::LatLngAlt>& points,
+                                       std::size_t k,
+                                       rng::Philox& gen,
+                                       unsigned int iterations = CLUSTERING_ITERATIONS);
+
+// k-means with the fewest clusters such that every point is within radius (meters) of its center
+std::vector<terrain::LatLngAlt> kMeansForRange(const std::vector<terrain::LatLngAlt>& points,
+                                               double radius,
+                                               rng::Philox& gen);
+
+// Voronoi k-medoids over candidate sites, starting from the sites closest to the given centers.
+// Devices join the closest medoid that reaches them, and each cluster moves to the site that
+// reaches most of its devices. Returns the distinct site indices.
+std::vector<std::size_t> kMedoids(const network::Network& net,
+                                  const coverage::CoverageMatrix& matrix,
+                                  const std::vector<std::size_t>& devices,
+                                  const std::vector<terrain::LatLngAlt>& centers,
+                                  unsigned int iterations = CLUSTERING_ITERATIONS);
+
+} // namespace clustering
+
+#endif // CLUSTERING_HPP
@@ -0,0 +1,30 @@
+#pragma once
+#ifndef COVERAGE_HPP
+#define COVERAGE_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include "global.hpp"
+#include "terrain.hpp"
+#include "network.hpp"
+
+/**
+ * 
+ * @brief Candidate gateway sites (the end devices each one can reach are in the coverage matrix).
+ * 
+ */
+
+#define CANDIDATE_SITE_SPACING 200.0 // Distance between candidate sites of the lattice (meters)
+#define CANDIDATE_SITE_HEIGHT 10.0 // Antenna height of candidate sites (meters)
+
+namespace coverage {
+
+// Square lattice of sites over the network bounding box (clipped to the elevation grid), without the sites outside the allowed zones or inside forbidden ones
+std::vector<terrain::LatLngAlt> candidateSites(const network::Network& net, 
+                                               double spacing = CANDIDATE_SITE_SPACING, 
+                                               double height = CANDIDATE_SITE_HEIGHT);
+
+} // namespace coverage
+
+#endif // COVERAGE_HPP
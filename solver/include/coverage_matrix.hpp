@@ -0,0 +1,141 @@
+#pragma once
+#ifndef COVERAGE_MATRIX_HPP
+#define COVERAGE_MATRIX_HPP
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "terrain.hpp"
+#include "network.hpp"
+
+/**
+ * 
+ * @brief Bitset coverage matrix (candidate sites x end devices) and set kernels for site selection.
+ * 
+ * Rows are 64-byte aligned and padded to a multiple of 512 bits, so the kernels can process
+ * whole AVX2 registers without tail handling. The AVX2 kernels are selected at runtime and
+ * fall back to scalar popcount on CPUs without AVX2.
+ * 
+ */
+
+#define COVERAGE_ALIGNMENT 64 // Bytes
+#define COVERAGE_WORDS_PER_BLOCK (COVERAGE_ALIGNMENT / 8) // 64 bit words per aligned block
+
+namespace coverage {
+
+template <typename T>
+struct AlignedAllocator {
+    using value_type = T;
+    AlignedAllocator() = default;
+    template <typename U> AlignedAllocator(const AlignedAllocator<U>&) {}
+    T* allocate(std::size_t n) {
+        const std::size_t bytes = (n * sizeof(T) + COVERAGE_ALIGNMENT - 1) / COVERAGE_ALIGNMENT * COVERAGE_ALIGNMENT;
+        void* ptr = std::aligned_alloc(COVERAGE_ALIGNMENT, bytes);
+        if (!ptr) throw std::bad_alloc();
+        return static_cast<T*>(ptr);
+    }
+    void deallocate(T* ptr, std::size_t) { std::free(ptr); }
+    template <typename U> bool operator==(const AlignedAllocator<U>&) const { return true; }
+    template <typename U> bool operator!=(const AlignedAllocator<U>&) const { return false; }
+};
+
+using Words = std::vector<std::uint64_t, AlignedAllocator<std::uint64_t>>;
+
+// Words needed for n bits, padded to whole aligned blocks
+inline std::size_t paddedWords(std::size_t bits) {
+    const std::size_t words = (bits + 63) / 64;
+    return (words + COVERAGE_WORDS_PER_BLOCK - 1) / COVERAGE_WORDS_PER_BLOCK * COVERAGE_WORDS_PER_BLOCK;
+}
+
+namespace bits { // Kernels over padded word arrays (words must be a multiple of COVERAGE_WORDS_PER_BLOCK)
+std::size_t popcount(const std::uint64_t* a, std::size_t words);
+std::size_t popcountAnd(const std::uint64_t* a, const std::uint64_t* b, std::size_t words); // |a & b|
+std::size_t popcountAndNot(const std::uint64_t* a, const std::uint64_t* b, std::size_t words); // |a & ~b|
+void orInto(std::uint64_t* dst, const std::uint64_t* src, std::size_t words); // dst |= src
+void andNotInto(std::uint64_t* dst, const std::uint64_t* src, std::size_t words); // dst &= ~src
+bool hasAVX2(); // True if the AVX2 kernels are used
+} // namespace bits
+
+// Set of end devices with the same layout as the rows of the matrix
+class DeviceSet {
+public:
+    DeviceSet() = default;
+    explicit DeviceSet(std::size_t devices) : devices(devices), words(paddedWords(devices), 0) {};
+
+    inline bool test(std::size_t e) const { return (words[e >> 6] >> (e & 63)) & 1ull; };
+    inline void set(std::size_t e) { words[e >> 6] |= 1ull << (e & 63); };
+    inline void reset(std::size_t e) { words[e >> 6] &= ~(1ull << (e & 63)); };
+    inline std::size_t count() const { return bits::popcount(words.data(), words.size()); };
+    inline std::size_t size() const { return devices; };
+    inline std::size_t numWords() const { return words.size(); };
+
+    inline std::uint64_t* data() { return words.data(); };
+    inline const std::uint64_t* data() const { return words.data(); };
+
+private:
+    std::size_t devices = 0;
+    Words words;
+};
+
+class CoverageMatrix {
+public:
+    CoverageMatrix() = default;
+    CoverageMatrix(const std::vector<terrain::LatLngAlt>& sites, std::size_t devices);
+
+    // Line of sight and range of every site to every end device, computed in parallel over sites
+    static CoverageMatrix build(const network::Network& net, const std::vector<terrain::LatLngAlt>& sites);
+    static CoverageMatrix fromSets(const std::vector<terrain::LatLngAlt>& sites, 
+                                   const std::vector<std::vector<std::uint32_t>>& sets, 
+                                   std::size_t devices);
+
+    // Binary file: header, sites and rows. The fingerprint identifies the end devices, sites, elevation grid and check parameters used to build it
+    static CoverageMatrix fromFile(const std::string& filepath);
+    // Loads the cached file if it matches the network and sites, otherwise builds it and saves it (if filepath is not empty)
+    static CoverageMatrix cached(const network::Network& net, const std::vector<terrain::LatLngAlt>& sites, const std::string& filepath);
+    void saveToFile(const std::string& filepath) const;
+    inline std::uint64_t getFingerprint() const { return fingerprint; };
+    static std::uint64_t fingerprintOf(const network::Network& net, const std::vector<terrain::LatLngAlt>& sites);
+
+    inline std::size_t getNumSites() const { return sites.size(); };
+    inline std::size_t getNumDevices() const { return devices; };
+    inline std::size_t getNumWords() const { return stride; };
+    inline const std::vector<terrain::LatLngAlt>& getSites() const { return sites; };
+
+    inline const std::uint64_t* row(std::size_t s) const { return rows.data() + s * stride; };
+    inline std::uint64_t* row(std::size_t s) { return rows.data() + s * stride; };
+    inline bool covers(std::size_t s, std::size_t e) const { return (row(s)[e >> 6] >> (e & 63)) & 1ull; };
+    inline void set(std::size_t s, std::size_t e) { row(s)[e >> 6] |= 1ull << (e & 63); };
+
+    inline std::size_t count(std::size_t s) const { return bits::popcount(row(s), stride); };
+    // Devices of site s not yet in the covered set
+    inline std::size_t gain(std::size_t s, const DeviceSet& covered) const { 
+        return bits::popcountAndNot(row(s), covered.data(), stride); 
+    };
+    // Devices covered by both sites
+    inline std::size_t overlap(std::size_t s1, std::size_t s2) const { 
+        return bits::popcountAnd(row(s1), row(s2), stride); 
+    };
+    inline void addTo(std::size_t s, DeviceSet& covered) const { bits::orInto(covered.data(), row(s), stride); };
+
+private:
+    std::vector<terrain::LatLngAlt> sites;
+    std::size_t devices = 0;
+    std::size_t stride = 0; // Words per row
+    std::uint64_t fingerprint = 0;
+    Words rows;
+};
+
+// Sparse rows of the matrix with the distance from the site to each end device, for optimizers that track assignments
+struct Link {
+    std::uint32_t device;
+    double distance; // Meters, as the distances recomputed by the optimizers
+};
+using SiteLinks = std::vector<std::vector<Link>>;
+SiteLinks siteLinks(const network::Network& net, const CoverageMatrix& matrix);
+
+} // namespace coverage
+
+#endif // COVERAGE_MATRIX_HPP
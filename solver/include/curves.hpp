@@ -0,0 +1,54 @@
+#pragma once
+#ifndef CURVES_HPP
+#define CURVES_HPP
+
+#include <cstdint>
+#include <utility>
+
+/**
+ *
+ * @brief Space filling curve keys of grid cells.
+ *
+ * Cells close along the curve are close in the plane, so sorting positions by their key 
+ * (or storing cells in key order) keeps neighbours close in memory.
+ *
+ */
+
+namespace curves {
+
+// Interleaves the bits of x (even bits of the key) and y (odd bits)
+inline std::uint64_t mortonKey(std::uint32_t x, std::uint32_t y) {
+    auto spread = [](std::uint64_t v) {
+        v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+        v = (v | (v << 8))  & 0x00FF00FF00FF00FFull;
+        v = (v | (v << 4))  & 0x0F0F0F0F0F0F0F0Full;
+        v = (v | (v << 2))  & 0x3333333333333333ull;
+        v = (v | (v << 1))  & 0x5555555555555555ull;
+        return v;
+    };
+    return spread(x) | (spread(y) << 1);
+};
+
+// Distance along the Hilbert curve that fills the square of side 2^bits (x, y < 2^bits, bits <= 31).
+// Unlike the Morton order, consecutive keys are always adjacent cells
+inline std::uint64_t hilbertKey(std::uint32_t x, std::uint32_t y, unsigned int bits) {
+    const std::uint32_t n = 1u << bits;
+    std::uint64_t key = 0;
+    for(std::uint32_t s = n >> 1; s > 0; s >>= 1) {
+        const std::uint32_t rx = (x & s) > 0;
+        const std::uint32_t ry = (y & s) > 0;
+        key += std::uint64_t(s) * s * ((3 * rx) ^ ry);
+        if(ry == 0) { // Rotate the quadrant
+            if(rx == 1) {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return key;
+};
+
+} // namespace curves
+
+#endif // CURVES_HPP
@@ -0,0 +1,65 @@
+#pragma once
+#ifndef DENSITY_HPP
+#define DENSITY_HPP
+
+#include <vector>
+
+#include "global.hpp"
+#include "terrain.hpp"
+
+/**
+ *
+ * @brief Density of points over a raster, answered through a summed-area table.
+ *
+ * Points are binned to the closest raster node. A rectangle sum costs four lookups, and a
+ * disc of radius R is the sum of one row span per raster row it crosses, so the densest
+ * position over the whole raster is found in O(cells x R / cell size) instead of
+ * O(cells x points).
+ *
+ */
+
+namespace density {
+
+class DensityMap {
+public:
+    DensityMap() = default;
+    // Raster of rows x cols nodes over the bounding box [minLng, minLat, maxLng, maxLat]
+    DensityMap(const std::vector<double>& bbox, std::size_t rows, std::size_t cols);
+
+    void clear();
+    void add(const terrain::LatLngAlt& position, double weight = 1.0);
+    void build(); // Summed-area table, call after adding the points and before the queries
+
+    inline std::size_t getRows() const { return rows; };
+    inline std::size_t getCols() const { return cols; };
+    terrain::LatLngAlt nodePosition(std::size_t row, std::size_t col, double alt = 0.0) const;
+
+    // Weight of the nodes in the inclusive range of rows and cols
+    double boxSum(std::size_t row0, std::size_t col0, std::size_t row1, std::size_t col1) const;
+    // Weight of the nodes within radius (meters) of the node
+    double discSum(std::size_t row, std::size_t col, double radius) const;
+    double discSum(const terrain::LatLngAlt& position, double radius) const;
+
+    // Node with the largest weight within radius, in parallel over rows (lowest row and col on ties).
+    // Returns false if the raster is empty
+    bool densest(double radius, std::size_t& row, std::size_t& col, double& weight) const;
+
+private:
+    double min_lat = 0.0, min_lng = 0.0;
+    double lat_step = 0.0, lng_step = 0.0; // Degrees between nodes
+    double row_meters = 0.0, col_meters = 0.0; // Meters between nodes
+    std::size_t rows = 0, cols = 0;
+    std::vector<double> counts; // rows x cols
+    std::vector<double> table; // (rows + 1) x (cols + 1), table[r][c] is the sum of counts above and left of (r, c)
+    double total = 0.0;
+
+    inline double at(std::size_t r, std::size_t c) const { return table[r * (cols + 1) + c]; };
+    std::size_t nearestRow(double lat) const;
+    std::size_t nearestCol(double lng) const;
+    std::vector<std::size_t> discWidths(double radius) const; // Half width in cols of the disc at each row offset
+    double discSum(std::size_t row, std::size_t col, const std::vector<std::size_t>& widths) const;
+};
+
+} // namespace density
+
+#endif // DENSITY_HPP
@@ -0,0 +1,75 @@
+#pragma once
+#ifndef EXACT_OPTIMIZER_HPP
+#define EXACT_OPTIMIZER_HPP
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include "global.hpp"
+#include "optimizer.hpp"
+#include "network.hpp"
+#include "coverage.hpp"
+#include "coverage_matrix.hpp"
+
+/**
+ * 
+ * @brief Exact minimum gateway count by branch and bound set cover over candidate sites.
+ * 
+ * Intended for small instances (about 200 end devices and 500 candidate sites after reduction).
+ * Dominated devices and sites are removed first, then a depth first search branches on the
+ * uncovered device with fewest sites. The search runs as OpenMP tasks sharing the incumbent and
+ * stops at the time limit, reporting the gap to the lower bound. Only end devices reachable
+ * from some site are required to be covered.
+ * 
+ */
+
+#define EXACT_TIME_LIMIT 30.0 // Seconds
+#define EXACT_TASK_DEPTH 3 // Search levels split into parallel tasks
+#define EXACT_CHECK_INTERVAL 1024 // Nodes between time limit checks
+
+class ExactOptimizer : public optimizer::Optimizer {
+public:
+    ExactOptimizer(network::Network& net, 
+                   double spacing = CANDIDATE_SITE_SPACING, 
+                   double height = CANDIDATE_SITE_HEIGHT) 
+        : optimizer::Optimizer(net), spacing(spacing), height(height) {};
+
+    void optimize(double timeLimit);
+    void optimize() override { optimize(EXACT_TIME_LIMIT); };
+
+    inline void setCoverageFile(const std::string& filepath) { coverage_file = filepath; };
+
+    inline bool isOptimal() const { return optimal; };
+    inline std::size_t getLowerBound() const { return lower_bound; }; // Gateways to add
+    inline std::size_t getUpperBound() const { return best_size; }; // Gateways added
+    inline double getGap() const { return best_size == 0 ? 0.0 : double(best_size - lower_bound) / best_size; };
+    inline std::size_t getNodes() const { return nodes; };
+
+private:
+    double spacing;
+    double height;
+    std::string coverage_file;
+
+    // Reduced problem: sites x devices that must be covered
+    coverage::CoverageMatrix rows;
+    std::vector<coverage::DeviceSet> cols; // Sites covering each device
+    std::vector<std::size_t> col_count;
+    std::vector<std::size_t> device_order; // Devices by increasing number of sites
+
+    std::atomic<std::size_t> best_size{0};
+    std::vector<std::size_t> best_solution; // Reduced site indices
+    std::mutex best_mutex;
+
+    std::atomic<std::size_t> nodes{0};
+    std::atomic<bool> stopped{false};
+    std::chrono::steady_clock::time_point search_deadline; // Own time limit or the optimizer deadline, the earliest
+
+    std::size_t lower_bound = 0;
+    bool optimal = false;
+
+    std::size_t lowerBound(const coverage::DeviceSet& covered) const;
+    void search(coverage::DeviceSet covered, std::vector<std::size_t> chosen, unsigned int depth);
+};
+
+#endif // EXACT_OPTIMIZER_HPP
@@ -64,6 +64,7 @@ public:
 
     static FeatureCollection fromGeoJSON(const std::string& filename);
     void saveToFile(const std::string& filename) const;
+    json toJSON() const;
 
     inline size_t featureCount() const { return features.size(); }
     inline Feature getFeature(size_t index) const { return features.at(index); }
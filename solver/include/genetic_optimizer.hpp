@@ -0,0 +1,80 @@
+#pragma once
+#ifndef GENETIC_OPTIMIZER_HPP
+#define GENETIC_OPTIMIZER_HPP
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "global.hpp"
+#include "optimizer.hpp"
+#include "network.hpp"
+#include "coverage.hpp"
+#include "coverage_matrix.hpp"
+
+/**
+ *
+ * @brief Genetic algorithm over sets of candidate sites for the Gateway Placement Problem.
+ *
+ * A genome is the sorted list of sites that get a gateway. Individuals of a generation are
+ * scored in parallel against the shared, read-only coverage matrix, and genomes scored in
+ * earlier generations are taken from a cache. Children take the sites of one parent on
+ * each side of a random line (spatial crossover), the best individuals pass unchanged.
+ * The cost is optimizer::deviceCost(), as in the annealing optimizer: gateways, unconnected devices and distance.
+ *
+ */
+
+#define GENETIC_POPULATION 64
+#define GENETIC_GENERATIONS 200
+#define GENETIC_ELITE 4 // Best individuals copied to the next generation
+#define GENETIC_TOURNAMENT 3 // Individuals competing for each parent slot
+#define GENETIC_MUTATION_RATE 0.3 // Probability of each mutation operator per child
+
+class GeneticOptimizer : public optimizer::Optimizer {
+public:
+    GeneticOptimizer(network::Network& net,
+                     double spacing = CANDIDATE_SITE_SPACING,
+                     double height = CANDIDATE_SITE_HEIGHT)
+        : optimizer::Optimizer(net), gen(rng::stream(0)), spacing(spacing), height(height) {};
+
+    void optimize(unsigned int generations);
+    void optimize() override { optimize(GENETIC_GENERATIONS); };
+
+    inline void setCoverageFile(const std::string& filepath) { coverage_file = filepath; };
+
+    inline unsigned long getCacheHits() const { return cache_hits; };
+
+private:
+    using Genome = std::vector<std::uint32_t>; // Sorted site indices
+
+    struct Fitness {
+        double cost = 0.0;
+        std::size_t connected = 0;
+        double distance = 0.0;
+    };
+
+    struct GenomeHash {
+        std::size_t operator()(const Genome& genome) const;
+    };
+
+    rng::Philox gen;
+    double spacing;
+    double height;
+    std::string coverage_file;
+
+    coverage::CoverageMatrix matrix;
+    coverage::SiteLinks site_devices;
+    std::vector<std::vector<std::uint32_t>> device_sites;
+    std::vector<double> fixed_dist; // Distance to the gateways of the input network, infinity if none
+    std::vector<std::vector<double>> buffers; // Per thread distances to the closest site
+
+    std::unordered_map<Genome, Fitness, GenomeHash> cache;
+    unsigned long cache_hits = 0;
+
+    Fitness evaluate(const Genome& genome, std::vector<double>& dist) const;
+    void evaluateAll(const std::vector<Genome>& population, std::vector<Fitness>& fitness);
+    Genome randomGenome();
+    Genome crossover(const Genome& a, const Genome& b);
+    void mutate(Genome& genome);
+};
+
+#endif // GENETIC_OPTIMIZER_HPP
@@ -10,8 +10,11 @@
 #include <sstream>
 #include <iomanip>
 #include <string>
+#include <vector>
 #include <random>
 
+#include "rng.hpp"
+
 // Same as __DBL_MAX__ from <cfloat> but compatible with C++17
 #define DBL_MAX std::numeric_limits<double>::max()
 
@@ -31,19 +34,21 @@ enum PRINT_TYPE { PLAIN_TEXT, JSON };
 std::string getExecutableDir();
 
 // Generate a simple UUID (not RFC4122 compliant, just for unique IDs)
-std::string generate_uuid();
+std::string generate_uuid(rng::Philox& gen);
 
 // Print help message from file
 inline constexpr const char defaultMessage[] = "Error in command line arguments. See manual or documentation.";
 void printHelp(const char* file, const char* message = defaultMessage); 
 
+// Split the OpenMP threads between concurrent tasks (outer) and the parallel loops inside each task (inner)
+void splitThreads(int tasks, int& outer, int& inner);
+
+// Manifest: one file per line (lines starting with # are ignored), relative paths are resolved from the manifest folder
+std::vector<std::string> readManifest(const std::string& filepath);
+
 // Convert degrees to radians
 inline double toRadians(double degree) { return degree * M_PI / 180.0; }
 
-// Random number generator
-static std::random_device rd;
-static std::mt19937 gen(rd());
-
 struct NullBuffer : std::streambuf {
     int overflow(int c) override { return c; }
 };
@@ -53,6 +58,7 @@ struct NullBuffer : std::streambuf {
 inline NullBuffer null_buffer;
 inline std::ostream null_stream(&null_buffer);
 inline std::ostream& dbg = null_stream;
+inline bool dbgEnabled() { return dbg.rdbuf() != &null_buffer; };
 
 } // namespace global
 
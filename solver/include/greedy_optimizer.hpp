@@ -0,0 +1,43 @@
+#pragma once
+#ifndef GREEDY_OPTIMIZER_HPP
+#define GREEDY_OPTIMIZER_HPP
+
+#include <vector>
+#include "global.hpp"
+#include "optimizer.hpp"
+#include "network.hpp"
+#include "coverage.hpp"
+#include "coverage_matrix.hpp"
+
+/**
+ * 
+ * @brief Lazy greedy (CELF) set cover over candidate sites for the Gateway Placement Problem.
+ * 
+ * Gateways are placed one at a time on the candidate site that connects the most uncovered
+ * end devices. Marginal gains only decrease as sites are selected, so stale gains kept in a
+ * priority queue are upper bounds and only the top of the queue has to be reevaluated.
+ * 
+ */
+
+#define GREEDY_MAX_GATEWAYS 100 // Stop after placing this many gateways
+
+class GreedyOptimizer : public optimizer::Optimizer {
+public:
+    GreedyOptimizer(network::Network& net, 
+                    double spacing = CANDIDATE_SITE_SPACING, 
+                    double height = CANDIDATE_SITE_HEIGHT) 
+        : optimizer::Optimizer(net), spacing(spacing), height(height) {};
+
+    void optimize(unsigned int maxGateways);
+    void optimize() override { optimize(GREEDY_MAX_GATEWAYS); };
+
+    // Binary file to cache the coverage matrix between runs (loaded if it matches, saved otherwise)
+    inline void setCoverageFile(const std::string& filepath) { coverage_file = filepath; };
+
+private:
+    double spacing;
+    double height;
+    std::string coverage_file;
+};
+
+#endif // GREEDY_OPTIMIZER_HPP
@@ -0,0 +1,48 @@
+#pragma once
+#ifndef MULTISTART_OPTIMIZER_HPP
+#define MULTISTART_OPTIMIZER_HPP
+
+#include <vector>
+#include <algorithm>
+#include "global.hpp"
+#include "optimizer.hpp"
+#include "network.hpp"
+#include "attractor_optimizer.h"
+
+/**
+ * 
+ * @brief Multi-start optimization: independent attractor replicas run concurrently and the best one is kept.
+ * 
+ */
+
+#define MULTISTART_REPLICAS 2 // Replicas of "multistart" when no number is given
+#define MULTISTART_ROUND 10 // Iterations run by every replica between comparisons
+#define MULTISTART_WARMUP 50 // Iterations before a replica can be discarded
+#define MULTISTART_DOMINANCE_MARGIN 0.1 // Fraction of end devices a replica must be behind to be discarded
+
+class MultiStartOptimizer : public optimizer::Optimizer {
+public:
+    MultiStartOptimizer(network::Network& net, 
+                        unsigned int replicas, 
+                        optimizer::OBJECTIVE objective = optimizer::MAX_COVERAGE)
+        : optimizer::Optimizer(net), replicas(replicas), objective(objective) {};
+
+    void optimize(unsigned int maxIterations = 500);
+    void optimize() override { optimize(500); };
+
+    inline unsigned int getDiscardedReplicas() const { return discarded; };
+
+    inline void setInitialization(INITIALIZATION init) { initialization = init; };
+    inline void setForceMode(FORCE_MODE mode) { force_mode = mode; };
+    inline void setCoverageFile(const std::string& filepath) { coverage_file = filepath; };
+
+private:
+    unsigned int replicas;
+    INITIALIZATION initialization = RANDOM_INIT;
+    FORCE_MODE force_mode = AGGREGATED_FORCE;
+    std::string coverage_file;
+    optimizer::OBJECTIVE objective;
+    unsigned int discarded = 0;
+};
+
+#endif // MULTISTART_OPTIMIZER_HPP
@@ -6,11 +6,16 @@
 #include <vector>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <unordered_map>
 
 #include "json.hpp"
 #include "feature_collection.hpp"
 #include "detail.hpp"
 #include "terrain.hpp"
+#include "zones.hpp"
+#include "projection.hpp"
+#include "visibility.hpp"
 
 /**
  * 
@@ -20,8 +25,10 @@
 namespace network {
 
 constexpr double MAX_RANGE = 2000; // Maximum distance (in meters) for a valid connection = 2km
-constexpr double MAX_RANGE_SQUARED = // Precomputed squared range for distance comparison
-    (MAX_RANGE * MAX_RANGE) / (terrain::EARTH_RADIUS * terrain::EARTH_RADIUS); 
+constexpr int CONNECT_CHUNK = 16; // End devices per scheduling chunk of connect(), consecutive ones are neighbours
+constexpr unsigned int ORDER_BITS = 16; // Bits per axis of the Hilbert keys of the end devices
+constexpr double DEDUP_TOLERANCE = 0.1; // End devices in the same cell of this size (meters, position and height) are co-located
+constexpr double MAX_RANGE_SQUARED = MAX_RANGE * MAX_RANGE; // Precomputed squared range for distance comparison in the local frame
 
 class Node {
 public:
@@ -49,6 +56,8 @@ public:
     inline bool lineOfSightTo(const Node& other) const {
         return elevation_grid->lineOfSight(location, other.location);
     }
+
+    inline void bindElevationGrid(const terrain::ElevationGrid* grid) { elevation_grid = grid; }
 private:
     const terrain::ElevationGrid* elevation_grid;
 };
@@ -68,6 +77,7 @@ public:
         terrain::LatLngAlt pos, 
         const terrain::ElevationGrid* grid) : Node(id, pos, grid) {}
     Gateway* assigned_gateway = nullptr; // Pointer to assigned gateway
+    std::size_t input_index = 0; // Position in the input (or order of addition), outputs follow it
 };
 
 
@@ -81,16 +91,58 @@ public:
     std::vector<EndDevice*> connected_devices; // Pointers to connected end devices
 };
 
+// Assignment of an end device as reported by the incremental (delta) API
+struct Assignment {
+    std::string end_device_id;
+    std::string gateway_id; // Empty if the end device is not connected
+    double distance = 0.0; // Distance to the assigned gateway (meters)
+};
+
+using Delta = std::vector<Assignment>; // Changed assignments after an edit
+
+// Cell of DEDUP_TOLERANCE (position in the local frame and height) of an end device
+struct PositionKey {
+    long long x = 0, y = 0, alt = 0;
+    inline bool operator==(const PositionKey& other) const { return x == other.x && y == other.y && alt == other.alt; };
+};
+
+struct PositionKeyHash {
+    inline std::size_t operator()(const PositionKey& key) const {
+        std::size_t hash = std::hash<long long>()(key.x);
+        hash ^= std::hash<long long>()(key.y) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+        hash ^= std::hash<long long>()(key.alt) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+        return hash;
+    };
+};
+
+// Storage order of the end devices, outputs always follow the input order
+enum ED_ORDER { INPUT_ORDER, HILBERT_ORDER };
+
+// Line of sight of connect(): exact, or between the centers of the cells (or blocks of cells) of the grid of both ends
+enum LOS_MODE { EXACT_LOS, CELL_LOS };
+
 class Network {
 public:
-    Network() = default;
+    Network() : elevation_grid(std::make_shared<terrain::ElevationGrid>()) {};
 
     Network(const std::vector<Gateway>& gws,
             const std::vector<EndDevice>& eds,
             const terrain::ElevationGrid& grid)
-        : gateways(gws), end_devices(eds), elevation_grid(grid) {}
+        : gateways(gws), end_devices(eds) { 
+        for (size_t e = 0; e < end_devices.size(); ++e) end_devices[e].input_index = e; // Outputs follow the given order
+        setElevationGrid(grid); 
+        updateFrame(); 
+        groupEndDevices(); 
+    }
+
+    // Copies relink assignments to their own nodes, the elevation grid is shared
+    Network(const Network& other);
+    Network& operator=(const Network& other);
+    Network(Network&&) = default;
+    Network& operator=(Network&&) = default;
     
-    inline void setElevationGrid(const terrain::ElevationGrid& grid) {elevation_grid = grid;};
+    inline void setElevationGrid(const terrain::ElevationGrid& grid) { setElevationGrid(std::make_shared<const terrain::ElevationGrid>(grid)); };
+    void setElevationGrid(std::shared_ptr<const terrain::ElevationGrid> grid); // Share a grid already loaded
     
     static Network fromGeoJSON(const std::string& filepath);
     static Network fromFeatureCollection(const geojson::FeatureCollection& fc);
@@ -100,15 +152,56 @@ public:
     void connect();
     void disconnect();
     inline const std::size_t getConnectedEdCount() const { return connected_eds_cnt; };
+    inline double getTotalDistance() const { return total_distance; };
 
     void print(global::PRINT_TYPE format = global::PLAIN_TEXT);
 
     inline std::vector<Gateway>& getGateways() { return gateways; };
+    inline std::size_t getGatewayCount() const { return gateways.size(); };
     inline const std::vector<EndDevice>& getEndDevices() const { return end_devices; };
 
     void addGateway(terrain::LatLngAlt pos);
+    // Reorders the end devices (disconnects the network). Networks are loaded in Hilbert order: consecutive end devices
+    // are close, so their links read the same part of the elevation grid
+    void orderEndDevices(ED_ORDER order);
+    // Replaces the gateways by nodes with these ids and positions (disconnects the network), to restore saved states
+    void setGateways(const std::vector<std::string>& ids, const std::vector<terrain::LatLngAlt>& positions);
+    inline const rng::Philox& getIdGenerator() const { return id_gen; };
+    inline void setIdGenerator(const rng::Philox& gen) { id_gen = gen; };
+
+    // Incremental edits: only the affected end devices are reassigned (requires a previous connect())
+    // Each call returns the assignments that changed (once per end device), added end devices are always reported
+    // and removed ones are reported as disconnected. Ids of added nodes must be new
+    Delta addEndDevice(const std::string& id, terrain::LatLngAlt pos);
+    Delta addGateway(const std::string& id, terrain::LatLngAlt pos);
+    Delta moveEndDevice(size_t index, terrain::LatLngAlt pos);
+    Delta moveGateway(size_t index, terrain::LatLngAlt pos);
+    Delta removeEndDevice(size_t index);
+    Delta removeGateway(size_t index);
+    Delta moveNode(const std::string& id, terrain::LatLngAlt pos);
+    Delta removeNode(const std::string& id);
+
+    // Index of node by id (-1 if not found)
+    int findEndDevice(const std::string& id) const;
+    int findGateway(const std::string& id) const;
     
-    inline const terrain::ElevationGrid& getElevationGrid() const { return elevation_grid; };
+    inline const terrain::ElevationGrid& getElevationGrid() const { return *elevation_grid; };
+    // Allowed and forbidden zones for the gateways placed by the optimizers
+    inline const zones::SiteConstraints& getSiteConstraints() const { return *site_constraints; };
+    // Local tangent plane of the network, range checks compare squared distances of projected positions with MAX_RANGE_SQUARED
+    inline const projection::LocalFrame& getFrame() const { return frame; };
+    // Planar distances between the nodes against haversine
+    projection::Accuracy projectionAccuracy() const;
+    // Co-located end devices share the range and line of sight checks of the first one of their group (its representative),
+    // this is the index of the representative of each end device (itself for the first one)
+    inline const std::vector<std::uint32_t>& getRepresentatives() const { return representative; };
+    inline std::size_t getUniquePositionCount() const { return groups.size(); };
+    // Approximate mode of connect() for early planning: links are checked once per pair of blocks of cells x cells grid cells.
+    // Incremental edits keep the exact check
+    void setLineOfSightMode(LOS_MODE mode, unsigned int cells = 1);
+    inline LOS_MODE getLineOfSightMode() const { return los_mode; };
+    // Approximate against exact line of sight on a sample of the links in range (with the cells of the current mode)
+    visibility::Agreement lineOfSightAgreement() const;
 
     // The following functions do not check bounds
     inline const terrain::LatLngAlt getEndDeviceLocation(size_t index) const { return end_devices[index].location; }
@@ -120,14 +213,66 @@ public:
 
     double computeTotalDistance() const;
 
+    // Extra properties added to the output (e.g. optimizer results)
+    inline void setProperty(const std::string& key, const nlohmann::json& value) { properties[key] = value; };
+    inline const nlohmann::json& getProperties() const { return properties; };
+
 private:
     std::vector<Gateway> gateways;
     std::vector<EndDevice> end_devices;
-    terrain::ElevationGrid elevation_grid;
+    std::shared_ptr<const terrain::ElevationGrid> elevation_grid; // Nodes point to this grid
+    std::shared_ptr<const zones::SiteConstraints> site_constraints = std::make_shared<zones::SiteConstraints>(); // Shared by copies
 
-    std::size_t connected_eds_cnt;
+    std::size_t connected_eds_cnt = 0;
+    double total_distance = 0.0; // Sum of distances from connected end devices to their gateways
     
     std::vector<double> bbox; // Bbox of network
+    projection::LocalFrame frame; // Tangent at the center of the nodes when the network is built
+    std::vector<std::uint32_t> representative; // First end device of the group of co-located ones
+    std::unordered_map<PositionKey, std::vector<std::uint32_t>, PositionKeyHash> groups; // End devices of each cell, sorted
+    LOS_MODE los_mode = EXACT_LOS;
+    unsigned int los_cells = 1; // Grid cells per side of the blocks of CELL_LOS
+
+    nlohmann::json properties = nlohmann::json::object();
+
+    rng::Philox id_gen = rng::stream(rng::NODE_ID_STREAM); // Ids of added gateways, reproducible for a given seed
+
+    // Tangent plane at the center of the current nodes
+    void updateFrame();
+    // Groups the end devices by position and height (in cells of DEDUP_TOLERANCE), after the end devices are reordered
+    void groupEndDevices();
+    PositionKey positionKey(const terrain::LatLngAlt& position) const;
+    // Incremental grouping of a single end device, only its group is updated
+    void joinGroup(size_t ed_index);
+    void leaveGroup(size_t ed_index, const PositionKey& key);
+    // End device indices in input order
+    std::vector<size_t> outputOrder() const;
+    std::vector<terrain::LatLngAlt> gatewayLocations() const;
+    std::vector<terrain::LatLngAlt> endDeviceLocations() const;
+    // Distance of each end device to its gateway (0 if not connected)
+    std::vector<double> assignmentDistances() const;
+    // Gateway positions in the local frame
+    std::vector<projection::Point> projectGateways() const;
+    // Closest gateway in range and line of sight (-1 if none), given the projected gateway positions
+    int bestGateway(const EndDevice& ed, const std::vector<projection::Point>& gw_points) const;
+    // Links from the gateways to the representative end devices in their range, by end device and gateway index
+    // (checked in the same direction as bestGateway()). The links of end device e are [offsets[e], offsets[e+1])
+    std::vector<visibility::Link> linksInRange(const std::vector<projection::Point>& ed_points, const std::vector<projection::Point>& gw_points,
+                                               std::vector<std::size_t>& offsets) const;
+    // Move end device to gateway (-1 to disconnect) updating counters, appends change to delta
+    void assign(size_t ed_index, int gw_index, Delta& changes);
+    // Current assignment of an end device
+    Assignment assignmentOf(size_t ed_index) const;
+    // Last assignment of each end device of changes (in order of first appearance), without those equal to their entry in before
+    static Delta netChanges(const Delta& changes, const Delta& before);
+    // Throws if an end device or gateway already has the id
+    void checkNewId(const std::string& id) const;
+    // Gateway index of each end device (-1 if not connected)
+    std::vector<int> assignedGateways() const;
+    // Rebuild pointers after the node vectors were reallocated or erased
+    void relink(const std::vector<int>& gw_indices);
+    // Flags end devices for which the gateway is reachable and closer than their current one
+    std::vector<char> improvedBy(int gw_index) const;
     
     void printPlainText() const;
     void printJSON() const;
@@ -2,6 +2,11 @@
 #ifndef OPTIMIZER_HPP
 #define OPTIMIZER_HPP
 
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <limits>
 #include "network.hpp"
 
 /**
@@ -10,16 +15,141 @@
  * 
  */
 
+#define MIN_GATEWAYS_COVERAGE_TOLERANCE 0.01 // Relative difference of connected end devices that MIN_GATEWAYS treats as the same coverage
+#define COST_UNCONNECTED_PENALTY 2.0 // Cost of an unconnected end device, in gateways
+#define COST_DISTANCE_WEIGHT 0.01 // Cost of an end device at MAX_RANGE from its gateway, in gateways
+
 namespace optimizer {
 
+enum OBJECTIVE { MAX_COVERAGE, MIN_GATEWAYS, MIN_DISTANCE };
+
+// Quality of a solution, used to compare runs of the optimizers
+struct Score {
+    std::size_t connected = 0; // Connected end devices
+    std::size_t gateways = 0;
+    double distance = 0.0; // Total distance from end devices to their gateways
+
+    static inline Score of(const network::Network& net) {
+        return {net.getConnectedEdCount(), net.getGatewayCount(), net.getTotalDistance()};
+    }
+
+    // Lexicographic comparison, coverage always goes first. MIN_GATEWAYS compares the gateways of 
+    // coverages within the tolerance, so fewer gateways cannot win by disconnecting end devices
+    inline bool betterThan(const Score& other, OBJECTIVE objective) const {
+        switch (objective) {
+            case MIN_GATEWAYS: {
+                const double margin = MIN_GATEWAYS_COVERAGE_TOLERANCE * std::max(connected, other.connected);
+                if (std::abs(double(connected) - double(other.connected)) > margin) return connected > other.connected;
+                if (gateways != other.gateways) return gateways < other.gateways;
+                if (connected != other.connected) return connected > other.connected;
+                return distance < other.distance;
+            }
+            case MIN_DISTANCE:
+                if (connected != other.connected) return connected > other.connected; // Distance only counts connected devices
+                if (distance != other.distance) return distance < other.distance;
+                return gateways < other.gateways;
+            case MAX_COVERAGE:
+            default:
+                if (connected != other.connected) return connected > other.connected;
+                if (gateways != other.gateways) return gateways < other.gateways;
+                return distance < other.distance;
+        }
+    }
+};
+
+enum STOP_REASON { NOT_STOPPED, CONVERGED, ITERATION_LIMIT, TIME_LIMIT, DISCARDED }; // DISCARDED: replica cut by the multi-start
+
+inline const char* stopReasonName(STOP_REASON reason) {
+    switch (reason) {
+        case CONVERGED: return "converged";
+        case ITERATION_LIMIT: return "iteration_limit";
+        case TIME_LIMIT: return "time_limit";
+        case DISCARDED: return "discarded";
+        case NOT_STOPPED:
+        default: return "not_stopped";
+    }
+}
+
+// Cost model of the annealing, genetic and swarm optimizers, in gateway units: one per gateway plus the cost of each end device
+inline double deviceCost(double distance) {
+    if (std::isinf(distance)) return COST_UNCONNECTED_PENALTY;
+    return COST_DISTANCE_WEIGHT * distance / network::MAX_RANGE;
+}
+
+// Distance of each end device to its gateway in the connected network, infinity if none. These optimizers keep
+// the gateways of the network, so their end devices only improve by distance
+inline std::vector<double> fixedDistances(network::Network& net) {
+    net.connect();
+    const auto& eds = net.getEndDevices();
+    std::vector<double> dist(eds.size(), std::numeric_limits<double>::infinity());
+    for (std::size_t e = 0; e < eds.size(); e++) {
+        if (eds[e].assigned_gateway != nullptr)
+            dist[e] = eds[e].distanceTo(*eds[e].assigned_gateway);
+    }
+    return dist;
+}
+
+// Progress of a run, the score is the best one found up to the iteration
+struct Sample {
+    unsigned long iteration = 0;
+    double elapsed_ms = 0.0;
+    Score best;
+};
+
 class Optimizer { // Base class
 public:
     Optimizer(network::Network& net) : network(net) {};
     virtual ~Optimizer() = default;
     virtual void optimize() = 0;
 
+    // Telemetry of the last run, comparable between algorithms
+    inline const std::vector<Sample>& getTelemetry() const { return telemetry; };
+    inline unsigned long getEvaluations() const { return evaluations; }; // Full or incremental objective evaluations
+    // Gateway positions without a permitted site nearby, their moves were skipped or the gateways were not added
+    inline unsigned long getSnapFailures() const { return snap_failures; };
+    inline double getElapsed() const { return telemetry.empty() ? 0.0 : telemetry.back().elapsed_ms; };
+
+    // Wall clock budget, checked by the optimizers between iterations. They stop with the best solution found so far
+    inline void setDeadline(std::chrono::steady_clock::time_point t) { deadline = t; };
+    inline void setTimeLimit(double seconds) {
+        deadline = std::chrono::steady_clock::now() + 
+                   std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+    };
+    inline STOP_REASON getStopReason() const { return stop_reason; };
+
 protected:
     network::Network& network;
+
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    STOP_REASON stop_reason = NOT_STOPPED;
+
+    inline bool deadlineReached() const {
+        return deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= deadline;
+    };
+
+    std::vector<Sample> telemetry;
+    unsigned long evaluations = 0;
+    unsigned long snap_failures = 0;
+    std::chrono::steady_clock::time_point started_at;
+
+    inline void startTelemetry() {
+        telemetry.clear();
+        evaluations = 0;
+        snap_failures = 0;
+        started_at = std::chrono::steady_clock::now();
+    };
+
+    inline double elapsedMs() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started_at).count();
+    };
+
+    // Coverage first, as reported by all the optimizers
+    inline void record(unsigned long iteration, const Score& score) {
+        Sample sample = {iteration, elapsedMs(), score};
+        if(!telemetry.empty() && !score.betterThan(telemetry.back().best, MAX_COVERAGE))
+            sample.best = telemetry.back().best;
+        telemetry.push_back(sample);
+    };
 };
 
 } // namespace optimizer
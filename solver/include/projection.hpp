@@ -0,0 +1,93 @@
+#pragma once
+#ifndef PROJECTION_HPP
+#define PROJECTION_HPP
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "json.hpp"
+#include "global.hpp"
+#include "terrain.hpp"
+
+/**
+ *
+ * @brief Local tangent plane (east, north) of a network, for planar distance checks.
+ *
+ * Positions are projected once (orthographic projection of the sphere on the plane tangent at 
+ * the center of the network), so range checks and comparisons are plain Euclidean arithmetic 
+ * instead of trigonometric functions for every pair. The relative error of a distance grows with
+ * the square of the distance of the points to the origin, about 3e-5 at 50 km.
+ *
+ */
+
+#define PROJECTION_ACCURACY_SAMPLES 1000 // Positions compared pairwise by the accuracy report
+
+namespace projection {
+
+struct Point {
+    double x = 0.0; // East of the origin (meters)
+    double y = 0.0; // North of the origin (meters)
+};
+
+inline double squaredDistance(const Point& a, const Point& b) {
+    const double dx = b.x - a.x, dy = b.y - a.y;
+    return dx*dx + dy*dy;
+};
+
+inline double distance(const Point& a, const Point& b) { return std::sqrt(squaredDistance(a, b)); };
+
+// Planar distances against haversine for pairs of positions
+struct Accuracy {
+    std::size_t pairs = 0;
+    double extent = 0.0; // Largest haversine distance (meters)
+    double max_error = 0.0; // meters
+    double max_relative_error = 0.0;
+    double mean_relative_error = 0.0;
+    std::size_t range_pairs = 0; // Pairs within the range by haversine
+    std::size_t range_disagreements = 0; // Pairs for which the planar range check differs from haversine
+    // Largest difference of the batch distances of terrain (indexed and matrix) from the scalar functions (meters)
+    double batch_haversine_error = 0.0;
+    double batch_equirectangular_error = 0.0;
+    double batch_slant_range_error = 0.0;
+
+    inline bool batchWithinTolerance() const { 
+        return std::max({batch_haversine_error, batch_equirectangular_error, batch_slant_range_error}) < BATCH_DISTANCE_TOLERANCE;
+    };
+
+    nlohmann::json toJSON() const;
+};
+
+class LocalFrame {
+public:
+    LocalFrame() = default; // Tangent at lat = 0, lng = 0
+    LocalFrame(double lat, double lng);
+    // Tangent at the center of the bounding box of the positions
+    static LocalFrame of(const std::vector<terrain::LatLngAlt>& positions);
+
+    inline Point project(const terrain::LatLngAlt& position) const {
+        const double phi = global::toRadians(position.lat);
+        const double dlambda = global::toRadians(position.lng - origin_lng);
+        const double cosphi = std::cos(phi);
+        return {
+            terrain::EARTH_RADIUS * cosphi * std::sin(dlambda),
+            terrain::EARTH_RADIUS * (std::sin(phi) * cos_lat - cosphi * sin_lat * std::cos(dlambda))
+        };
+    };
+    std::vector<Point> project(const std::vector<terrain::LatLngAlt>& positions) const;
+
+    inline double getOriginLat() const { return origin_lat; };
+    inline double getOriginLng() const { return origin_lng; };
+
+    // Compares the planar distances between (a sample of) the positions with the haversine distance,
+    // and the range check against the given range, and the batch distances of terrain against the scalar ones
+    Accuracy accuracy(const std::vector<terrain::LatLngAlt>& positions, const terrain::ElevationGrid& grid, double range) const;
+
+private:
+    double origin_lat = 0.0, origin_lng = 0.0;
+    double sin_lat = 0.0, cos_lat = 1.0;
+};
+
+} // namespace projection
+
+#endif // PROJECTION_HPP
@@ -0,0 +1,40 @@
+#pragma once
+#ifndef PRUNING_OPTIMIZER_HPP
+#define PRUNING_OPTIMIZER_HPP
+
+#include <vector>
+#include "global.hpp"
+#include "optimizer.hpp"
+#include "network.hpp"
+
+/**
+ * 
+ * @brief Reverse greedy pruning of redundant gateways, run after another optimizer.
+ * 
+ * Every end device keeps the number of gateways that can reach it, and every gateway the number
+ * of devices only it reaches (the coverage lost if it is removed). The gateway that loses the
+ * least is removed and only the counts of its devices are updated, so no connect() is needed
+ * between removals. The removed gateways are then taken out of the network, which only
+ * reassigns the devices they served.
+ * 
+ */
+
+#define PRUNING_MAX_LOSS 0 // Connected end devices that the pruning can lose
+
+class PruningOptimizer : public optimizer::Optimizer {
+public:
+    // Gateways before index first are kept (e.g. the gateways of the input network)
+    PruningOptimizer(network::Network& net, std::size_t first = 0) 
+        : optimizer::Optimizer(net), first(first) {};
+
+    void optimize(unsigned int maxLoss);
+    void optimize() override { optimize(PRUNING_MAX_LOSS); };
+
+    inline std::size_t getRemovedGateways() const { return removed_count; };
+
+private:
+    std::size_t first;
+    std::size_t removed_count = 0;
+};
+
+#endif // PRUNING_OPTIMIZER_HPP
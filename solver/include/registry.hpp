@@ -0,0 +1,72 @@
+#pragma once
+#ifndef REGISTRY_HPP
+#define REGISTRY_HPP
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <functional>
+
+#include "json.hpp"
+#include "optimizer.hpp"
+#include "network.hpp"
+#include "attractor_optimizer.h"
+
+/**
+ *
+ * @brief Registry of the optimization algorithms, run by name with a common set of parameters.
+ *
+ * Every algorithm reports the same result (final score, stop reason, evaluations and telemetry),
+ * so the solver and the benchmark driver do not depend on the concrete optimizers. New
+ * algorithms are added with registerAlgorithm().
+ *
+ */
+
+namespace optimizer {
+
+struct Parameters {
+    // Budget of the algorithm: iterations, generations, moves or gateways (0 for the default of the algorithm)
+    unsigned long iterations = 0;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    std::string coverage_file; // Cache of the coverage matrix for site selection algorithms
+
+    // Attractor and multi-start
+    unsigned int starts = 0; // Replicas of the multi-start attractor, 0 for MULTISTART_REPLICAS
+    OBJECTIVE objective = MAX_COVERAGE; // Criterion to select the best replica
+    INITIALIZATION initialization = RANDOM_INIT;
+    FORCE_MODE force_mode = AGGREGATED_FORCE;
+    std::string checkpoint_file;
+    unsigned int checkpoint_interval = CHECKPOINT_INTERVAL;
+    std::string resume_file; // Checkpoint to continue from
+};
+
+struct Result {
+    std::string algorithm;
+    Score score; // Final network
+    STOP_REASON stop_reason = NOT_STOPPED;
+    double elapsed_ms = 0.0;
+    unsigned long evaluations = 0;
+    unsigned long snap_failures = 0; // Gateway moves or additions skipped for lack of a permitted site
+    std::vector<Sample> telemetry;
+
+    inline double evaluationsPerSecond() const { return elapsed_ms > 0.0 ? 1000.0 * evaluations / elapsed_ms : 0.0; };
+    nlohmann::json toJSON(bool withTelemetry = false) const;
+};
+
+struct Algorithm {
+    std::string name;
+    std::string description;
+    std::function<Result(network::Network&, const Parameters&)> run; // Optimizes the network in place
+};
+
+const std::vector<Algorithm>& algorithms(); // Registration order
+const Algorithm* findAlgorithm(const std::string& name); // nullptr if not registered
+std::string algorithmNames(); // Comma separated
+void registerAlgorithm(const Algorithm& algorithm); // Replaces the algorithm with the same name
+
+// Runs the algorithm on the network, throws if it is not registered
+Result run(const std::string& name, network::Network& net, const Parameters& params);
+
+} // namespace optimizer
+
+#endif // REGISTRY_HPP
@@ -0,0 +1,97 @@
+#pragma once
+#ifndef RNG_HPP
+#define RNG_HPP
+
+#include <cstdint>
+#include <array>
+#include <limits>
+
+/**
+ * 
+ * @brief Seedable counter-based random number streams (Philox4x32-10).
+ * 
+ * Every stream is identified by (seed, stream id), so each replica or thread can draw from its
+ * own independent sequence and runs are reproducible for a given seed regardless of scheduling.
+ * 
+ */
+
+namespace rng {
+
+// Stream ids reserved for specific uses (optimizer runs use ids starting from 0)
+constexpr std::uint64_t NODE_ID_STREAM = 1ull << 62; // Ids of gateways added by the optimizers
+
+// Philox4x32-10 generator, satisfies UniformRandomBitGenerator so it works with <random> distributions
+class Philox {
+public:
+    using result_type = std::uint32_t;
+
+    Philox(std::uint64_t seed = 0, std::uint64_t stream = 0) : seed(seed), stream(stream) {};
+
+    static constexpr result_type min() { return 0; };
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); };
+
+    inline result_type operator()() {
+        if (index == 0) block = generate(position / 4);
+        const result_type value = block[index];
+        index = (index + 1) % 4;
+        position++;
+        return value;
+    };
+
+    // Skip n values, O(1) since every block only depends on its counter
+    inline void discard(std::uint64_t n) {
+        position += n;
+        index = position % 4;
+        if (index != 0) block = generate(position / 4);
+    };
+
+    inline std::uint64_t getSeed() const { return seed; };
+    inline std::uint64_t getStream() const { return stream; };
+    inline std::uint64_t getPosition() const { return position; }; // Values drawn so far
+
+    // Generator of the stream after drawing position values (restores a saved state)
+    static inline Philox at(std::uint64_t seed, std::uint64_t stream, std::uint64_t position) {
+        Philox gen(seed, stream);
+        gen.discard(position);
+        return gen;
+    };
+
+private:
+    std::uint64_t seed;
+    std::uint64_t stream;
+    std::uint64_t position = 0;
+    unsigned int index = 0; // Next value of the current block
+    std::array<result_type, 4> block{};
+
+    inline std::array<result_type, 4> generate(std::uint64_t counter) const {
+        constexpr std::uint32_t M0 = 0xD2511F53, M1 = 0xCD9E8D57; // Multipliers
+        constexpr std::uint32_t W0 = 0x9E3779B9, W1 = 0xBB67AE85; // Weyl key increments
+        std::array<std::uint32_t, 4> ctr = {
+            static_cast<std::uint32_t>(counter), static_cast<std::uint32_t>(counter >> 32),
+            static_cast<std::uint32_t>(stream),  static_cast<std::uint32_t>(stream >> 32)
+        };
+        std::uint32_t k0 = static_cast<std::uint32_t>(seed), k1 = static_cast<std::uint32_t>(seed >> 32);
+        for (int round = 0; round < 10; ++round) {
+            const std::uint64_t p0 = static_cast<std::uint64_t>(M0) * ctr[0];
+            const std::uint64_t p1 = static_cast<std::uint64_t>(M1) * ctr[2];
+            ctr = {
+                static_cast<std::uint32_t>(p1 >> 32) ^ ctr[1] ^ k0, static_cast<std::uint32_t>(p1),
+                static_cast<std::uint32_t>(p0 >> 32) ^ ctr[3] ^ k1, static_cast<std::uint32_t>(p0)
+            };
+            k0 += W0;
+            k1 += W1;
+        }
+        return ctr;
+    };
+};
+
+// Global seed, taken from std::random_device unless set (set it before creating any stream)
+void setSeed(std::uint64_t seed);
+std::uint64_t getSeed();
+
+// Independent stream of the global seed
+inline Philox stream(std::uint64_t id) { return Philox(getSeed(), id); };
+
+} // namespace rng
+
+#endif // RNG_HPP
@@ -0,0 +1,66 @@
+#pragma once
+#ifndef SWARM_OPTIMIZER_HPP
+#define SWARM_OPTIMIZER_HPP
+
+#include <vector>
+#include "global.hpp"
+#include "optimizer.hpp"
+#include "network.hpp"
+
+/**
+ *
+ * @brief Particle swarm optimization over continuous gateway coordinates.
+ *
+ * Each particle is a full configuration of up to SWARM_MAX_GATEWAYS gateways, with latitude,
+ * longitude and an activation value per gateway (the gateway exists if it is positive), so
+ * the number of gateways is optimized too. Particles are evaluated in parallel with their own
+ * buffers and random stream, allocated once per run, so the result does not depend on the
+ * number of threads. The cost is optimizer::deviceCost(), as in the site based optimizers: gateways,
+ * unconnected devices and distance. Gateways already in the network are kept fixed.
+ *
+ */
+
+#define SWARM_PARTICLES 32
+#define SWARM_ITERATIONS 200
+#define SWARM_MAX_GATEWAYS 16 // Gateway slots per particle
+#define SWARM_GATEWAY_HEIGHT 10.0 // Antenna height (meters)
+#define SWARM_INERTIA 0.72
+#define SWARM_COGNITIVE 1.49 // Attraction to the particle best
+#define SWARM_SOCIAL 1.49 // Attraction to the swarm best
+#define SWARM_MAX_VELOCITY 0.1 // Fraction of the bounding box per iteration
+
+class SwarmOptimizer : public optimizer::Optimizer {
+public:
+    SwarmOptimizer(network::Network& net, unsigned int particles = SWARM_PARTICLES)
+        : optimizer::Optimizer(net), swarm(particles) {};
+
+    void optimize(unsigned int maxIterations);
+    void optimize() override { optimize(SWARM_ITERATIONS); };
+
+private:
+    // Per gateway slot: lat, lng, activation
+    static constexpr std::size_t DIMS = 3;
+
+    struct Fitness {
+        double cost = 0.0;
+        std::size_t connected = 0;
+        std::size_t gateways = 0;
+        double distance = 0.0;
+    };
+
+    struct Particle {
+        rng::Philox gen;
+        std::vector<double> position, velocity, best_position;
+        Fitness fitness, best_fitness;
+        std::vector<double> dist; // Distance of each device to its closest gateway
+    };
+
+    std::vector<Particle> swarm;
+    std::vector<double> fixed_dist; // Distance to the gateways of the input network, infinity if none
+    std::vector<projection::Point> ed_points; // End devices in the local frame of the network
+    std::vector<double> lower, upper, max_velocity; // Per dimension
+
+    Fitness evaluate(const std::vector<double>& position, std::vector<double>& dist) const;
+};
+
+#endif // SWARM_OPTIMIZER_HPP
@@ -8,6 +8,8 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <array>
+#include <cstdint>
 
 #include "global.hpp"
 
@@ -15,6 +17,9 @@
 #define US915_LORA_LAMBDA 0.327642031 // in meters (for 915 MHz)
 #define EU860_LORA_LAMBDA 0.345383016 // in meters (for 868 MHz)
 #define FRESNEL_CLEARANCE_FACTOR 0.6 // 60% clearance
+#define GRID_TILE_BITS 3 // Tiles of the Z-order grid layout have 2^bits x 2^bits cells (8 x 8 doubles = 8 cache lines)
+#define ASIN_SERIES_LIMIT 0.05 // Half chords of the unit sphere (about 640 km) below which the batch haversine uses an arcsine series
+#define BATCH_DISTANCE_TOLERANCE 1e-8 // Largest difference (meters) of the batch distances from the scalar functions
 // WGS-84 constants
 #define SEMI_MAJOR_AXIS 6378137.0 // semi-major axis
 #define EARTH_ECCENTRICITY 0.00669437999 // eccentricity^2
@@ -66,6 +71,23 @@ struct LatLngAlt {
 
 struct Vec3 { double x, y, z; };
 
+// Storage of the elevation grid: rows one after the other, or square tiles in Morton (Z) order, 
+// so the cells around a position are usually in the same tile whatever the direction of the path
+enum GRID_LAYOUT { ROW_MAJOR, Z_ORDER_TILES };
+
+// Link question answered against a sampled terrain profile
+struct LinkScenario {
+    double observerHeight = 2.0; // Antenna heights above the terrain (meters)
+    double targetHeight = 2.0;
+    double wavelength = 0.0; // Meters, 0 for plain line of sight (e.g. US915_LORA_LAMBDA for Fresnel zone clearance)
+    double clearanceFactor = FRESNEL_CLEARANCE_FACTOR; // Fraction of the first Fresnel zone that must be clear
+};
+
+struct LinkResult {
+    bool clear = true;
+    double margin = 0.0; // Smallest height of the line (minus the required clearance) above the terrain (meters), negative if blocked
+};
+
 class FeatureCollection {
 public:
     FeatureCollection() = default;
@@ -101,6 +123,16 @@ public:
                      bool fresnelClearance = false) const;
     bool lineOfSight(const LatLngAlt pos1, const LatLngAlt pos2, bool fresnelClearance = false) const;
 
+    // Several scenarios (heights, wavelength and clearance) over the same path with a single terrain walk,
+    // results are in the order of the scenarios
+    std::vector<LinkResult> lineOfSight(double lat1, double lng1,
+                                        double lat2, double lng2,
+                                        const std::vector<LinkScenario>& scenarios) const;
+    // Same, for a profile given by terrainProfile() (endpoints included) and the length of the path in meters
+    static std::vector<LinkResult> lineOfSight(const std::vector<double>& profile,
+                                               double pathLength,
+                                               const std::vector<LinkScenario>& scenarios);
+
     // Haversine distance between two lat/lng points in meters
     double haversineDistance(double lat1, double lng1, double lat2, double lng2) const;
     double haversineDistance(const LatLngAlt pos1, const LatLngAlt pos2) const;
@@ -142,11 +174,37 @@ public:
 
     inline size_t getNumLatitudes() const { return latitudes.size(); };
     inline size_t getNumLongitudes() const { return longitudes.size(); };
+    // Hash of the dimensions, axes and elevations (independent of the layout), identifies the grid in cached results
+    inline std::uint64_t getChecksum() const { return checksum; };
+
+    // Reorders the storage of the elevations, values and results do not change
+    void setLayout(GRID_LAYOUT newLayout);
+    inline GRID_LAYOUT getLayout() const { return layout; };
+    // Storage offsets of the cells read by bilinearInterpolation() at the position, for locality measurements
+    std::array<std::size_t, 4> interpolationOffsets(double lat, double lng) const;
+
+    // Blocks of cells x cells grid cells (super-cells), positions outside the grid belong to the closest block.
+    // Index of the block of a position, and its center (altitude kept)
+    std::uint64_t cellKey(double lat, double lng, unsigned int cells = 1) const;
+    LatLngAlt cellCenter(const LatLngAlt& pos, unsigned int cells = 1) const;
 
 private:
     std::vector<double> latitudes;
     std::vector<double> longitudes;
-    std::vector<std::vector<double>> elevationGrid;
+    std::vector<double> elevations; // Cells in the order of the layout
+    std::uint64_t checksum = 0;
+
+    GRID_LAYOUT layout = ROW_MAJOR;
+    std::size_t tile_cols = 0; // Tiles per row of tiles
+    std::vector<std::uint32_t> tile_slot; // Position of each tile (row-major index) in the storage
+
+    inline std::size_t offset(std::size_t i, std::size_t j) const {
+        if (layout == ROW_MAJOR) return i * longitudes.size() + j;
+        constexpr std::size_t mask = (std::size_t(1) << GRID_TILE_BITS) - 1;
+        const std::size_t tile = tile_slot[(i >> GRID_TILE_BITS) * tile_cols + (j >> GRID_TILE_BITS)];
+        return (tile << (2 * GRID_TILE_BITS)) | ((i & mask) << GRID_TILE_BITS) | (j & mask);
+    };
+    inline double at(std::size_t i, std::size_t j) const { return elevations[offset(i, j)]; };
 
     int findIndex(const std::vector<double>& vec, double value) const;
 };
@@ -164,4 +222,20 @@ Vec3 toECEF(double lat, double lng, double h);
 
 LatLngAlt getCentroid(const std::vector<LatLngAlt>& points); // Points must have lat and lng members
 
+// Batch distances in meters. The trigonometry of each position is computed once, so the loops over pairs 
+// are only products, sums and square roots (vectorized). Results differ from the scalar functions of ElevationGrid
+// by less than BATCH_DISTANCE_TOLERANCE (rounding of either side), checked by the projection report of eval:
+//  - haversine: from the chord between the unit vectors (same formula, a = (chord / 2)^2), with an arcsine series up to
+//    ASIN_SERIES_LIMIT (about 640 km, truncation below 3e-15 relative) and std::asin beyond
+//  - equirectangular: cosine of the mean latitude from the sine and cosine of half the latitude of the endpoints
+//  - slant range: ECEF straight line distance with the altitudes as heights, same operations as straightLineDistance()
+// Indexed: out[i] is the distance from from[i] to to[index[i]], 0 where the index is negative
+void haversineDistances(const std::vector<LatLngAlt>& from, const std::vector<LatLngAlt>& to, const std::vector<int>& index, std::vector<double>& out);
+void equirectangularDistances(const std::vector<LatLngAlt>& from, const std::vector<LatLngAlt>& to, const std::vector<int>& index, std::vector<double>& out);
+void slantRanges(const std::vector<LatLngAlt>& from, const std::vector<LatLngAlt>& to, const std::vector<int>& index, std::vector<double>& out);
+// Matrices: out[r * cols.size() + c] is the distance from rows[r] to cols[c]
+void haversineMatrix(const std::vector<LatLngAlt>& rows, const std::vector<LatLngAlt>& cols, std::vector<double>& out);
+void equirectangularMatrix(const std::vector<LatLngAlt>& rows, const std::vector<LatLngAlt>& cols, std::vector<double>& out);
+void slantRangeMatrix(const std::vector<LatLngAlt>& rows, const std::vector<LatLngAlt>& cols, std::vector<double>& out);
+
 } // namespace terrain
\ No newline at end of file
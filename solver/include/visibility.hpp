@@ -0,0 +1,69 @@
+#pragma once
+#ifndef VISIBILITY_HPP
+#define VISIBILITY_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include "json.hpp"
+#include "terrain.hpp"
+
+/**
+ *
+ * @brief Approximate line of sight between cells of the elevation grid, for early planning.
+ *
+ * Both ends of a link are snapped to the center of their cell of the grid (or of a block of
+ * cells x cells cells), keeping their heights, so every link between the same pair of cells
+ * and heights has the same result and the terrain is walked once per pair. The error depends
+ * on the terrain and on the size of the cells, so it is measured against the exact check on
+ * a sample of the links of each network.
+ *
+ */
+
+#define LOS_AGREEMENT_SAMPLES 1000 // Links compared with the exact check by the agreement report
+
+namespace visibility {
+
+// Link from the position from[from] to the position to[to]
+struct Link {
+    std::uint32_t from = 0;
+    std::uint32_t to = 0;
+};
+
+// Approximate against exact line of sight
+struct Agreement {
+    unsigned int cells = 1; // Grid cells per side of the blocks
+    std::size_t links = 0; // All the links
+    std::size_t cell_pairs = 0; // Unique pairs of cells and heights of the links (evaluations of the approximate mode)
+    std::size_t samples = 0; // Links compared
+    std::size_t clear = 0; // Sampled links clear by the exact check
+    std::size_t false_clear = 0; // Blocked links reported as clear
+    std::size_t false_blocked = 0; // Clear links reported as blocked
+
+    inline double disagreementRate() const { return samples > 0 ? double(false_clear + false_blocked) / samples : 0.0; };
+    nlohmann::json toJSON() const;
+};
+
+class CellLineOfSight {
+public:
+    CellLineOfSight(const terrain::ElevationGrid& grid, unsigned int cells = 1);
+
+    inline terrain::LatLngAlt snap(const terrain::LatLngAlt& position) const { return grid->cellCenter(position, cells); };
+    inline bool lineOfSight(const terrain::LatLngAlt& a, const terrain::LatLngAlt& b) const { return grid->lineOfSight(snap(a), snap(b)); };
+    // Result of each link (1 if clear), evaluated once per unique pair of cells and heights
+    std::vector<char> lineOfSight(const std::vector<terrain::LatLngAlt>& from, const std::vector<terrain::LatLngAlt>& to, const std::vector<Link>& links) const;
+    // Compares with the exact check on an evenly spaced sample of (up to LOS_AGREEMENT_SAMPLES) links
+    Agreement agreement(const std::vector<terrain::LatLngAlt>& from, const std::vector<terrain::LatLngAlt>& to, const std::vector<Link>& links) const;
+
+private:
+    const terrain::ElevationGrid* grid;
+    unsigned int cells;
+
+    // Links sorted by pair of cells and heights, and the start of each run of the same pair (plus the end)
+    void groupLinks(const std::vector<terrain::LatLngAlt>& from, const std::vector<terrain::LatLngAlt>& to, const std::vector<Link>& links,
+                    std::vector<std::uint32_t>& order, std::vector<std::size_t>& runs) const;
+};
+
+} // namespace visibility
+
+#endif // VISIBILITY_HPP
@@ -0,0 +1,99 @@
+#pragma once
+#ifndef ZONES_HPP
+#define ZONES_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include "global.hpp"
+#include "terrain.hpp"
+#include "feature_collection.hpp"
+
+/**
+ *
+ * @brief Allowed and forbidden zones (GeoJSON polygons) for gateway placement.
+ *
+ * Polygon edges are bucketed in a uniform grid of cells, and each cell stores the polygons
+ * that contain its center. A containment query only tests the edges of the cell of the point
+ * against the segment from the cell center to the point, so it costs a few crossing tests
+ * regardless of the number of polygons and vertices.
+ *
+ */
+
+#define ZONE_INDEX_MAX_CELLS 65536 // Cells of the containment grid
+#define ZONE_INDEX_CELLS_PER_EDGE 4 // Cells of the containment grid per polygon edge (up to the max)
+#define ZONE_SNAP_RESOLUTION 256 // Nodes per side of the raster of permitted positions used to snap
+#define ZONE_SNAP_EDGE_OFFSET 0.01 // Meters off the boundary of the positions snapped to an edge when no node of the raster is permitted
+
+namespace zones {
+
+// Union of polygons (with holes), even-odd rule within each polygon
+class ZoneIndex {
+public:
+    ZoneIndex() = default;
+    explicit ZoneIndex(const std::vector<geojson::Polygon>& polygons);
+
+    bool contains(const terrain::LatLngAlt& position) const;
+    inline bool empty() const { return num_polygons == 0; };
+    inline std::vector<double> getBoundingBox() const { return {min_x, min_y, max_x, max_y}; }; // minLng, minLat, maxLng, maxLat
+    // Closest point of every edge to the position, moved the offset (meters) to both sides of the edge. 
+    // Meters per degree of longitude and latitude around the position are given
+    void boundaryPoints(const terrain::LatLngAlt& position, double lng_meters, double lat_meters, double offset, 
+                        std::vector<terrain::LatLngAlt>& points) const;
+
+private:
+    struct Edge {
+        double x0, y0, x1, y1; // lng, lat
+        std::uint32_t polygon;
+    };
+
+    std::size_t num_polygons = 0;
+    double min_x = 0.0, min_y = 0.0, max_x = 0.0, max_y = 0.0;
+    double cell_w = 0.0, cell_h = 0.0; // Degrees
+    std::size_t rows = 0, cols = 0;
+
+    std::vector<Edge> edges;
+    // Compressed rows: entries of cell i are in [start[i], start[i + 1]), sorted by polygon
+    std::vector<std::uint32_t> edge_start, cell_edges; // Edges crossing the cell
+    std::vector<std::uint32_t> inside_start, cell_inside; // Polygons containing the cell center
+
+    inline std::size_t cell(std::size_t r, std::size_t c) const { return r * cols + c; };
+    inline double centerX(std::size_t c) const { return min_x + (c + 0.5) * cell_w; };
+    inline double centerY(std::size_t r) const { return min_y + (r + 0.5) * cell_h; };
+};
+
+class SiteConstraints {
+public:
+    SiteConstraints() = default;
+    // Polygon and MultiPolygon features with type "allowed_zone" or "forbidden_zone"
+    explicit SiteConstraints(const std::vector<geojson::Feature>& features);
+
+    inline bool empty() const { return allowed.empty() && forbidden.empty(); };
+    // Inside an allowed zone (if there is any) and outside every forbidden zone
+    inline bool permits(const terrain::LatLngAlt& position) const {
+        return (allowed.empty() || allowed.contains(position)) && !forbidden.contains(position);
+    };
+    // Moves the position (altitude kept) to the closest permitted node of the snap raster if it is not permitted.
+    // Zones too narrow for the raster are reached by the closest permitted point next to their edges.
+    // Returns false (and the position is not changed) if there is no permitted position
+    bool snap(terrain::LatLngAlt& position) const;
+
+    inline const std::vector<geojson::Feature>& getFeatures() const { return features; };
+
+private:
+    std::vector<geojson::Feature> features;
+    ZoneIndex allowed, forbidden;
+
+    double min_lat = 0.0, min_lng = 0.0;
+    double lat_step = 0.0, lng_step = 0.0; // Degrees between nodes
+    double row_meters = 0.0, col_meters = 0.0; // Meters between nodes
+    std::size_t rows = 0, cols = 0;
+    std::vector<char> permitted; // rows x cols
+
+    // Closest permitted point next to the edges of the zones, exact but linear in the number of edges
+    bool snapToBoundary(terrain::LatLngAlt& position) const;
+};
+
+} // namespace zones
+
+#endif // ZONES_HPP
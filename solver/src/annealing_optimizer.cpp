@@ -0,0 +1,246 @@
+#include "../include/annealing_optimizer.hpp"
+#include <algorithm>
+#include <limits>
+
+double AnnealingOptimizer::siteDistance(std::size_t s, std::size_t e) const {
+    return network.getElevationGrid().haversineDistance(matrix.getSites()[s], network.getEndDevices()[e].location);
+};
+
+void AnnealingOptimizer::rescan(std::size_t e) {
+    const double inf = std::numeric_limits<double>::infinity();
+    best_site[e] = second_site[e] = NONE;
+    best_dist[e] = second_dist[e] = inf;
+    for(std::size_t s : active) {
+        if(!matrix.covers(s, e)) continue;
+        const double dist = siteDistance(s, e);
+        if(dist < best_dist[e]) {
+            second_site[e] = best_site[e];
+            second_dist[e] = best_dist[e];
+            best_site[e] = s;
+            best_dist[e] = dist;
+        } else if(dist < second_dist[e]) {
+            second_site[e] = s;
+            second_dist[e] = dist;
+        }
+    }
+};
+
+// Cost change of removing and adding a site (NONE to skip either), visiting only the devices in range of both
+double AnnealingOptimizer::delta(std::size_t removed, std::size_t added) {
+    evaluations++;
+    stamp++;
+    pending_connected = 0;
+    pending_distance = 0.0;
+
+    double change = 0.0;
+    if(added != NONE) {
+        change += 1.0;
+        for(const auto& [e, dist] : site_devices[added]) {
+            mark[e] = stamp;
+            added_dist[e] = dist;
+        }
+    }
+    if(removed != NONE)
+        change -= 1.0;
+
+    auto visit = [&](std::size_t e) {
+        double next = best_site[e] == removed ? second_dist[e] : best_dist[e];
+        if(mark[e] == stamp)
+            next = std::min(next, added_dist[e]);
+        const double before = std::min(fixed_dist[e], best_dist[e]);
+        const double after = std::min(fixed_dist[e], next);
+        if(before == after) return;
+        change += optimizer::deviceCost(after) - optimizer::deviceCost(before);
+        pending_connected += long(!std::isinf(after)) - long(!std::isinf(before));
+        pending_distance += (std::isinf(after) ? 0.0 : after) - (std::isinf(before) ? 0.0 : before);
+    };
+
+    if(added != NONE) {
+        for(const auto& entry : site_devices[added])
+            visit(entry.device);
+    }
+    if(removed != NONE) {
+        for(const auto& entry : site_devices[removed])
+            if(mark[entry.device] != stamp) visit(entry.device);
+    }
+
+    return change;
+};
+
+// Commits a move evaluated by the last call to delta()
+void AnnealingOptimizer::apply(std::size_t removed, std::size_t added) {
+    if(removed != NONE) {
+        used[removed] = 0;
+        active.erase(std::find(active.begin(), active.end(), removed));
+        for(const auto& entry : site_devices[removed]) {
+            const std::size_t e = entry.device;
+            if(best_site[e] == removed || second_site[e] == removed)
+                rescan(e);
+        }
+    }
+
+    if(added != NONE) {
+        used[added] = 1;
+        active.push_back(added);
+        for(const auto& [e, dist] : site_devices[added]) {
+            if(dist < best_dist[e]) {
+                second_site[e] = best_site[e];
+                second_dist[e] = best_dist[e];
+                best_site[e] = added;
+                best_dist[e] = dist;
+            } else if(dist < second_dist[e]) {
+                second_site[e] = added;
+                second_dist[e] = dist;
+            }
+        }
+    }
+
+    connected += pending_connected;
+    total_distance += pending_distance;
+};
+
+// Random site in range of a random unconnected end device, NONE if the device found is connected or unreachable
+std::size_t AnnealingOptimizer::siteForUnconnected() {
+    std::uniform_int_distribution<std::size_t> device(0, device_sites.size() - 1);
+    const std::size_t e = device(gen);
+    if(!std::isinf(std::min(fixed_dist[e], best_dist[e])) || device_sites[e].empty())
+        return NONE;
+    std::uniform_int_distribution<std::size_t> site(0, device_sites[e].size() - 1);
+    return device_sites[e][site(gen)];
+};
+
+// Random site in range of a random end device served by site s, so the gateway moves locally
+std::size_t AnnealingOptimizer::siteNear(std::size_t s) {
+    if(site_devices[s].empty())
+        return NONE;
+    std::uniform_int_distribution<std::size_t> device(0, site_devices[s].size() - 1);
+    const auto& sites = device_sites[site_devices[s][device(gen)].device];
+    std::uniform_int_distribution<std::size_t> site(0, sites.size() - 1);
+    return sites[site(gen)];
+};
+
+void AnnealingOptimizer::optimize(unsigned long moves) {
+
+    startTelemetry();
+    stop_reason = optimizer::NOT_STOPPED;
+
+    matrix = coverage::CoverageMatrix::cached(
+        network, coverage::candidateSites(network, spacing, height), coverage_file);
+    const std::size_t num_sites = matrix.getNumSites();
+    const std::size_t num_devices = network.getEndDevices().size();
+
+    global::dbg << "Candidate sites: " << num_sites << std::endl;
+
+    if(num_sites == 0 || num_devices == 0) {
+        network.connect();
+        return;
+    }
+
+    site_devices = coverage::siteLinks(network, matrix);
+    device_sites.assign(num_devices, {});
+    for(std::size_t s = 0; s < num_sites; s++) {
+        for(const auto& entry : site_devices[s])
+            device_sites[entry.device].push_back(s);
+    }
+
+    fixed_dist = optimizer::fixedDistances(network);
+    const double inf = std::numeric_limits<double>::infinity();
+    const std::size_t fixed_gateways = network.getGatewayCount();
+
+    active.clear();
+    used.assign(num_sites, 0);
+    best_site.assign(num_devices, NONE);
+    second_site.assign(num_devices, NONE);
+    best_dist.assign(num_devices, inf);
+    second_dist.assign(num_devices, inf);
+    mark.assign(num_devices, 0);
+    added_dist.assign(num_devices, inf);
+    stamp = 0;
+    accepted = 0;
+
+    connected = 0;
+    total_distance = 0.0;
+    cost = 0.0;
+    for(std::size_t e = 0; e < num_devices; e++) {
+        cost += optimizer::deviceCost(fixed_dist[e]);
+        if(!std::isinf(fixed_dist[e])) {
+            connected++;
+            total_distance += fixed_dist[e];
+        }
+    }
+
+    std::vector<std::size_t> best_active;
+    double best_cost = cost;
+    optimizer::Score best_score = {connected, fixed_gateways, total_distance};
+
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::uniform_int_distribution<std::size_t> any_site(0, num_sites - 1);
+    const double cooling = std::log(ANNEALING_FINAL_TEMPERATURE / ANNEALING_INITIAL_TEMPERATURE);
+
+    unsigned long k = 0;
+    for(; k < moves; k++) {
+        if(k % ANNEALING_DEADLINE_INTERVAL == 0 && deadlineReached()) {
+            global::dbg << "Time limit reached after " << k << " moves" << std::endl;
+            stop_reason = optimizer::TIME_LIMIT;
+            break;
+        }
+
+        const double temperature = ANNEALING_INITIAL_TEMPERATURE * std::exp(cooling * double(k) / moves);
+
+        // Pick a move: add (towards unconnected devices when possible), remove or relocate
+        std::size_t removed = NONE, added = NONE;
+        const double type = uniform(gen);
+        if(active.empty() || type < 0.25) {
+            added = siteForUnconnected();
+            if(added == NONE) added = any_site(gen);
+        } else {
+            std::uniform_int_distribution<std::size_t> any_active(0, active.size() - 1);
+            removed = active[any_active(gen)];
+            if(type >= 0.5) { // Relocate
+                added = uniform(gen) < 0.5 ? siteForUnconnected() : NONE;
+                if(added == NONE) added = siteNear(removed);
+                if(added == NONE || added == removed) continue;
+            }
+        }
+        if(added != NONE && used[added]) continue;
+
+        const double change = delta(removed, added);
+        if(change <= 0.0 || uniform(gen) < std::exp(-change / temperature)) {
+            apply(removed, added);
+            cost += change;
+            accepted++;
+            if(cost < best_cost - 1e-9) {
+                best_cost = cost;
+                best_active = active;
+                best_score = {connected, fixed_gateways + active.size(), total_distance};
+            }
+        }
+
+        if(k % ANNEALING_TELEMETRY_INTERVAL == 0)
+            record(k, best_score);
+    }
+
+    if(stop_reason == optimizer::NOT_STOPPED)
+        stop_reason = optimizer::ITERATION_LIMIT;
+
+    global::dbg << "Annealing moves: " << k << ", accepted: " << accepted
+                << ", best cost: " << best_cost << " (" << best_active.size() << " gateways)" << std::endl;
+
+    for(std::size_t s : best_active)
+        network.addGateway(matrix.getSites()[s]);
+    network.connect();
+    record(k, optimizer::Score::of(network));
+
+    const double elapsed = getElapsed();
+    network.setProperty("optimization", {
+        {"algorithm", "annealing"},
+        {"moves", k},
+        {"accepted_moves", accepted},
+        {"gateways_added", best_active.size()},
+        {"cost", best_cost},
+        {"candidate_sites", num_sites},
+        {"elapsed_ms", elapsed},
+        {"moves_per_second", elapsed > 0.0 ? k / elapsed * 1000.0 : 0.0},
+        {"stop_reason", optimizer::stopReasonName(stop_reason)}
+    });
+};
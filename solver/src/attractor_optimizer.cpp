@@ -1,4 +1,67 @@
 #include "../include/attractor_optimizer.h"
+#include "../include/clustering.hpp"
+#include "../include/coverage.hpp"
+#include "../include/density.hpp"
+#include "../include/coverage_matrix.hpp"
+#include <fstream>
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+#include <cstdio>
+
+namespace {
+    constexpr char CHECKPOINT_MAGIC[4] = {'V', 'D', 'C', 'K'};
+    constexpr std::uint32_t CHECKPOINT_VERSION = 2;
+
+    template <typename T>
+    void writeValue(std::ofstream& file, const T& value) { file.write(reinterpret_cast<const char*>(&value), sizeof(T)); }
+
+    template <typename T>
+    T readValue(std::ifstream& file) {
+        T value{};
+        file.read(reinterpret_cast<char*>(&value), sizeof(T));
+        return value;
+    }
+
+    void writeGenerator(std::ofstream& file, const rng::Philox& gen) {
+        writeValue(file, gen.getSeed());
+        writeValue(file, gen.getStream());
+        writeValue(file, gen.getPosition());
+    }
+
+    rng::Philox readGenerator(std::ifstream& file) {
+        const auto seed = readValue<std::uint64_t>(file);
+        const auto stream = readValue<std::uint64_t>(file);
+        const auto position = readValue<std::uint64_t>(file);
+        return rng::Philox::at(seed, stream, position);
+    }
+
+    void writeGateways(std::ofstream& file, network::Network& net) {
+        writeValue<std::uint64_t>(file, net.getGatewayCount());
+        for(const auto& gw : net.getGateways()) {
+            writeValue<std::uint32_t>(file, gw.id.size());
+            file.write(gw.id.data(), gw.id.size());
+            writeValue(file, gw.location.lat);
+            writeValue(file, gw.location.lng);
+            writeValue(file, gw.location.alt);
+        }
+    }
+
+    void readGateways(std::ifstream& file, std::vector<std::string>& ids, std::vector<terrain::LatLngAlt>& positions) {
+        const auto count = readValue<std::uint64_t>(file);
+        if(!file || count > (1ull << 32)) 
+            throw std::runtime_error("Invalid checkpoint file");
+        ids.resize(count);
+        positions.resize(count);
+        for(std::size_t g = 0; g < count; g++) {
+            ids[g].resize(readValue<std::uint32_t>(file));
+            file.read(ids[g].data(), ids[g].size());
+            positions[g].lat = readValue<double>(file);
+            positions[g].lng = readValue<double>(file);
+            positions[g].alt = readValue<double>(file);
+        }
+    }
+}
 
 terrain::LatLngAlt AttractorOptimizer::findOptimalGatewayPosition() {
     // Find centroid of unconnected devices
@@ -18,11 +81,11 @@ terrain::LatLngAlt AttractorOptimizer::findOptimalGatewayPosition() {
         centroid.alt /= unconnected_count;
         
         // Add some randomness to avoid exact overlap
-        static std::uniform_real_distribution<> noise(-0.001, 0.001);
+        std::uniform_real_distribution<> noise(-0.001, 0.001);
         
-        centroid.lat += noise(global::gen);
-        centroid.lng += noise(global::gen);
-        centroid.alt += noise(global::gen);
+        centroid.lat += noise(gen);
+        centroid.lng += noise(gen);
+        centroid.alt += noise(gen);
         
         return centroid;
     }
@@ -31,78 +94,260 @@ terrain::LatLngAlt AttractorOptimizer::findOptimalGatewayPosition() {
 };
 
 terrain::LatLngAlt AttractorOptimizer::findMaxDensityPosition() {
+    // Unconnected devices binned on a raster with the resolution of the elevation grid
+    density::DensityMap map(network.getBoundingBox(), 
+                            network.getElevationGrid().getNumLatitudes(), 
+                            network.getElevationGrid().getNumLongitudes());
+    for(const auto& device : network.getEndDevices()) {
+        if(device.assigned_gateway == nullptr)
+            map.add(device.location);
+    }
+    map.build();
+
+    std::size_t row, col;
+    double weight;
+    if(!map.densest(network::MAX_RANGE, row, col, weight))
+        return {0.0, 0.0, 0.0}; // Invalid position if no unconnected devices
+
+    return map.nodePosition(row, col, 2.0);
+};
+
+terrain::LatLngAlt AttractorOptimizer::randomPosition() {
     std::vector<double> bbox = network.getBoundingBox();
-    
-    double best_density = 0.0;
-    terrain::LatLngAlt best_position = {0.0, 0.0, 0.0};
 
-    double lat_step = (bbox[3] - bbox[1]) / network.getElevationGrid().getNumLatitudes();
-    double lng_step = (bbox[2] - bbox[0]) / network.getElevationGrid().getNumLongitudes();
-    
-    for(size_t i = 0; i < network.getElevationGrid().getNumLatitudes(); ++i) {
-        for(size_t j = 0; j < network.getElevationGrid().getNumLongitudes(); ++j) {
-            terrain::LatLngAlt test_pos = {
-                bbox[1] + i * lat_step,
-                bbox[0] + j * lng_step,
-                2.0
-            };
-            
-            // Count unconnected devices within range
-            int nearby_unconnected = 0;
-            for(const auto& device : network.getEndDevices()) {
-                if(device.assigned_gateway == nullptr) {
-                    double distance = network.getElevationGrid().equirectangularDistance(test_pos, device.location);
-                    if(distance < network::MAX_RANGE) { // Define this constant
-                        nearby_unconnected++;
-                    }
+    std::uniform_real_distribution<> disLat(bbox[1], bbox[3]);
+    std::uniform_real_distribution<> disLng(bbox[0], bbox[2]);
+    std::uniform_real_distribution<> disAlt(2.0, 10.0); // Altitude between 2m and 10m for antennas
+
+    return {disLat(gen), disLng(gen), disAlt(gen)};
+};
+
+// One gateway per cluster of unconnected end devices, clusters fit within the connection range
+std::vector<terrain::LatLngAlt> AttractorOptimizer::clusterPositions() {
+    network.connect();
+    std::vector<terrain::LatLngAlt> points;
+    std::vector<std::size_t> devices;
+    for(std::size_t e = 0; e < network.getEndDevices().size(); e++) {
+        if(network.getEndDevices()[e].assigned_gateway == nullptr) {
+            points.push_back(network.getEndDevices()[e].location);
+            devices.push_back(e);
+        }
+    }
+
+    std::vector<terrain::LatLngAlt> clusters = clustering::kMeansForRange(points, network::MAX_RANGE, gen);
+    std::vector<terrain::LatLngAlt> positions;
+    for(auto& position : clusters) {
+        position.alt = INITIAL_GATEWAY_HEIGHT;
+        if(network.getSiteConstraints().snap(position)) {
+            positions.push_back(position);
+        } else {
+            snap_failures++; // The cluster gets no gateway
+            *log << "No permitted site for the cluster at (lat: " << position.lat << ", lng: " << position.lng << ")" << std::endl;
+        }
+    }
+
+    if(initialization == KMEDOIDS_INIT && !positions.empty()) { // Snap to the candidate sites that reach the clusters
+        if(!coverage_matrix)
+            coverage_matrix = std::make_shared<const coverage::CoverageMatrix>(coverage::CoverageMatrix::cached(
+                network, coverage::candidateSites(network), coverage_file));
+        const coverage::CoverageMatrix& matrix = *coverage_matrix;
+        std::vector<terrain::LatLngAlt> medoids;
+        for(std::size_t s : clustering::kMedoids(network, matrix, devices, positions))
+            medoids.push_back(matrix.getSites()[s]);
+        if(!medoids.empty())
+            positions = medoids;
+    }
+
+    // Positions reaching the most unconnected end devices first, so the cap of start() keeps the largest clusters
+    const terrain::ElevationGrid& grid = network.getElevationGrid();
+    std::vector<std::size_t> reach(positions.size(), 0);
+    #pragma omp parallel for schedule(dynamic)
+    for(int p = 0; p < static_cast<int>(positions.size()); p++) {
+        for(const auto& point : points) {
+            if(grid.haversineDistance(positions[p], point) < network::MAX_RANGE)
+                reach[p]++;
+        }
+    }
+    std::vector<std::size_t> order(positions.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return reach[a] > reach[b]; });
+    std::vector<terrain::LatLngAlt> ranked(positions.size());
+    for(std::size_t k = 0; k < order.size(); k++)
+        ranked[k] = positions[order[k]];
+    return ranked;
+};
+
+// Every end device pulls with a constant weight (1/N if connected to the gateway, 1/nced otherwise),
+// so the total force on a gateway only depends on the count and sum of positions of each group
+void AttractorOptimizer::aggregatedForces(std::size_t nced, std::vector<terrain::LatLngAlt>& forces) const {
+    const auto& eds = network.getEndDevices();
+    const auto& gws = network.getGateways();
+    const double num_eds = eds.size();
+
+    terrain::LatLngAlt sum_all = {0.0, 0.0, 0.0};
+    std::vector<terrain::LatLngAlt> sum_connected(gws.size(), {0.0, 0.0, 0.0});
+    std::vector<std::size_t> connected(gws.size(), 0);
+    for(const auto& ed : eds) {
+        sum_all += ed.location;
+        if(ed.assigned_gateway != nullptr) {
+            const std::size_t g = ed.assigned_gateway - gws.data();
+            sum_connected[g] += ed.location;
+            connected[g]++;
+        }
+    }
+
+    for(std::size_t g = 0; g < gws.size(); g++) {
+        const terrain::LatLngAlt& x = gws[g].location;
+        const double others = num_eds - connected[g];
+        forces[g] = {
+            (sum_connected[g].lat - connected[g] * x.lat) / num_eds + (sum_all.lat - sum_connected[g].lat - others * x.lat) / nced,
+            (sum_connected[g].lng - connected[g] * x.lng) / num_eds + (sum_all.lng - sum_connected[g].lng - others * x.lng) / nced,
+            0.0
+        };
+    }
+};
+
+// Same sum as the exact forces, over contiguous arrays: the weight of each end device is selected from its gateway 
+// index instead of comparing pointers, and the end devices of a tile are reused by a block of gateways
+void AttractorOptimizer::blockedForces(std::size_t nced, std::vector<terrain::LatLngAlt>& forces) {
+    const auto& eds = network.getEndDevices();
+    const auto& gws = network.getGateways();
+    const std::size_t num_eds = eds.size();
+    const std::size_t num_gws = gws.size();
+
+    if(ed_lat.size() != num_eds) {
+        ed_lat.resize(num_eds);
+        ed_lng.resize(num_eds);
+        for(std::size_t e = 0; e < num_eds; e++) {
+            ed_lat[e] = eds[e].location.lat;
+            ed_lng[e] = eds[e].location.lng;
+        }
+    }
+    assignment.resize(num_eds);
+    for(std::size_t e = 0; e < num_eds; e++)
+        assignment[e] = eds[e].assigned_gateway != nullptr ? std::int32_t(eds[e].assigned_gateway - gws.data()) : -1;
+
+    const double connected_weight = 1.0 / num_eds;
+    const double other_weight = 1.0 / nced;
+    const double* lat = ed_lat.data();
+    const double* lng = ed_lng.data();
+    const std::int32_t* gw = assignment.data();
+
+    #pragma omp parallel for schedule(dynamic)
+    for(std::size_t first = 0; first < num_gws; first += FORCE_GATEWAY_BLOCK) {
+        const std::size_t block = std::min<std::size_t>(FORCE_GATEWAY_BLOCK, num_gws - first);
+        double x_lat[FORCE_GATEWAY_BLOCK], x_lng[FORCE_GATEWAY_BLOCK];
+        double f_lat[FORCE_GATEWAY_BLOCK] = {0.0}, f_lng[FORCE_GATEWAY_BLOCK] = {0.0};
+        for(std::size_t k = 0; k < block; k++) {
+            x_lat[k] = gws[first + k].location.lat;
+            x_lng[k] = gws[first + k].location.lng;
+        }
+
+        for(std::size_t tile = 0; tile < num_eds; tile += FORCE_DEVICE_TILE) {
+            const std::size_t end = std::min<std::size_t>(tile + FORCE_DEVICE_TILE, num_eds);
+            for(std::size_t k = 0; k < block; k++) {
+                const std::int32_t g = first + k;
+                const double gx_lat = x_lat[k], gx_lng = x_lng[k];
+                double sum_lat = 0.0, sum_lng = 0.0;
+                #pragma omp simd reduction(+:sum_lat,sum_lng)
+                for(std::size_t e = tile; e < end; e++) {
+                    const double w = gw[e] == g ? connected_weight : other_weight;
+                    sum_lat += (lat[e] - gx_lat) * w;
+                    sum_lng += (lng[e] - gx_lng) * w;
                 }
-            }
-            
-            if(nearby_unconnected > best_density) {
-                best_density = nearby_unconnected;
-                best_position = test_pos;
+                f_lat[k] += sum_lat;
+                f_lng[k] += sum_lng;
             }
         }
-    }
-    
-    return best_position;
-}
 
-void AttractorOptimizer::optimize(unsigned int maxIterations) {
+        for(std::size_t k = 0; k < block; k++)
+            forces[first + k] = {f_lat[k], f_lng[k], 0.0};
+    }
+};
 
-    std::vector<double> bbox = network.getBoundingBox();
+void AttractorOptimizer::start(unsigned int maxIterations) {
+    max_iterations = maxIterations;
+    iteration = 0;
+    stagnant_iterations = 0;
+    gateways_added = 1; // Start with one gateway
+    stop_reason = optimizer::NOT_STOPPED;
+    best_state.reset();
+    startTelemetry();
 
-    static std::uniform_real_distribution<> disLat(bbox[1], bbox[3]);
-    static std::uniform_real_distribution<> disLng(bbox[0], bbox[2]);
-    static std::uniform_real_distribution<> disAlt(2.0, 10.0); // Altitude between 2m and 10m for antennas
+    if(initialization != RANDOM_INIT) {
+        const std::vector<terrain::LatLngAlt> positions = clusterPositions();
+        gateways_added = 0;
+        for(const auto& position : positions) {
+            if(gateways_added >= MAX_GATEWAYS_TO_ADD) {
+                *log << "Gateway limit reached, " << positions.size() - gateways_added << " clusters left without a gateway" << std::endl;
+                break;
+            }
+            network.addGateway(position);
+            gateways_added++;
+        }
+        if(gateways_added > 0) {
+            *log << "Initial gateways added by clustering: " << gateways_added << std::endl;
+            return;
+        }
+        gateways_added = 1; // The random gateway below
+    }
 
     // add first gateway at random position
-    terrain::LatLngAlt initial_pos = {disLat(global::gen), disLng(global::gen), disAlt(global::gen)};
+    terrain::LatLngAlt initial_pos = randomPosition();
+    for(int retry = 0; !network.getSiteConstraints().snap(initial_pos); retry++) {
+        snap_failures++;
+        if(retry + 1 >= SNAP_RETRIES)
+            throw std::runtime_error("No permitted site for the initial gateway within the allowed zones");
+        initial_pos = randomPosition();
+    }
     network.addGateway(initial_pos);
-    global::dbg << "Initial gateway added at (lat: " << initial_pos.lat 
+    *log << "Initial gateway added at (lat: " << initial_pos.lat 
               << ", lng: " << initial_pos.lng 
               << ", alt: " << initial_pos.alt << ")" << std::endl;
+};
 
-    int stagnant_iterations = 0;
-    int gateways_added = 1; // Start with one gateway
+bool AttractorOptimizer::step() {
 
-    for(unsigned int iter = 0; iter < maxIterations; iter++){
+    if(stop_reason != optimizer::NOT_STOPPED)
+        return false;
 
-        global::dbg << "Iteration " << iter+1 << "/" << maxIterations << std::endl;
+    if(iteration >= max_iterations) {
+        stop_reason = optimizer::ITERATION_LIMIT;
+        return false;
+    }
 
-        network.connect(); // This disconnects before connecting
+    if(deadlineReached()) {
+        *log << "Time limit reached at iteration " << iteration << std::endl;
+        stop_reason = optimizer::TIME_LIMIT;
+        return false;
+    }
 
-        // Not connected end-devices count
-        const std::size_t nced = network.getEndDevices().size() - network.getConnectedEdCount();
+    const unsigned int iter = iteration++;
 
-        if(nced == 0){
-            global::dbg << "All devices connected at iteration " << iter << std::endl;
-            break;
-        }
+    *log << "Iteration " << iter+1 << "/" << max_iterations << std::endl;
+
+    network.connect(); // This disconnects before connecting
+    evaluations++;
+    const optimizer::Score score = optimizer::Score::of(network);
+    record(iteration, score);
+    if(!best_state || score.betterThan(best_score, optimizer::MAX_COVERAGE)) {
+        best_state = std::make_unique<network::Network>(network);
+        best_score = score;
+    }
+
+    // Not connected end-devices count
+    const std::size_t nced = network.getEndDevices().size() - network.getConnectedEdCount();
 
-        // Used as vector
-        std::vector<terrain::LatLngAlt> velocities(network.getGateways().size(), {0.0, 0.0, 0.0});
+    if(nced == 0){
+        *log << "All devices connected at iteration " << iter << std::endl;
+        stop_reason = optimizer::CONVERGED;
+        return false;
+    }
+
+    // Used as vector
+    std::vector<terrain::LatLngAlt> velocities(network.getGateways().size(), {0.0, 0.0, 0.0});
 
+    if(force_mode == EXACT_FORCE) {
         #pragma omp parallel for schedule(dynamic) // parallelize over gateways
         for(std::size_t g = 0; g < network.getGateways().size(); g++) {
             terrain::LatLngAlt total_force = {0.0, 0.0, 0.0}; // Thread-local
@@ -120,57 +365,205 @@ void AttractorOptimizer::optimize(unsigned int maxIterations) {
             }
 
             velocities[g] = total_force;
-            network.translateGateway(g, velocities[g]);
         }
+    } else if(force_mode == BLOCKED_FORCE) {
+        blockedForces(nced, velocities);
+    } else {
+        aggregatedForces(nced, velocities);
+    }
 
-        double total_velocity = 0.0;
-        for (const auto& vel : velocities) {
-            total_velocity += std::sqrt(vel.lat*vel.lat + vel.lng*vel.lng);
+    const zones::SiteConstraints& constraints = network.getSiteConstraints();
+    for(std::size_t g = 0; g < network.getGateways().size(); g++) {
+        const terrain::LatLngAlt previous = network.getGatewayLocation(g);
+        network.translateGateway(g, velocities[g]);
+        if(!constraints.empty()) { // Back to a permitted position, the velocity is the actual displacement
+            terrain::LatLngAlt position = network.getGatewayLocation(g);
+            if(!constraints.snap(position)) { // Move skipped
+                position = previous;
+                snap_failures++;
+            }
+            network.setGatewayLocation(g, position);
+            velocities[g] = position - previous;
         }
-        double avg_velocity = total_velocity / velocities.size();
+    }
+
+    double total_velocity = 0.0;
+    for (const auto& vel : velocities) {
+        total_velocity += std::sqrt(vel.lat*vel.lat + vel.lng*vel.lng);
+    }
+    double avg_velocity = total_velocity / velocities.size();
 
-        global::dbg << "Average gateway velocity: " << avg_velocity << " meters/iteration" << std::endl;
+    *log << "Average gateway velocity: " << avg_velocity << " meters/iteration" << std::endl;
+    
+    // Check for stagnation
+    if(avg_velocity < STAGNATION_THRESHOLD) {
+        stagnant_iterations++;
         
-        // Check for stagnation
-        if(avg_velocity < STAGNATION_THRESHOLD) {
-            stagnant_iterations++;
+        // If stagnated for enough iterations and still have unconnected devices
+        if(stagnant_iterations >= STAGNATION_PATIENCE && nced > 0 && gateways_added < MAX_GATEWAYS_TO_ADD) {
             
-            // If stagnated for enough iterations and still have unconnected devices
-            if(stagnant_iterations >= STAGNATION_PATIENCE && nced > 0 && gateways_added < MAX_GATEWAYS_TO_ADD) {
-                
-                // Strategy 1: Add gateway near unconnected device cluster
-                terrain::LatLngAlt new_position = findOptimalGatewayPosition();
+            // Strategy 1: Add gateway where most unconnected devices are within range
+            terrain::LatLngAlt new_position = findMaxDensityPosition();
 
-                // Strategy 2: If strategy 1 fails, use random position
-                if(new_position.lat == 0.0 && new_position.lng == 0.0) {
-                    global::dbg << "No unconnected devices found for optimal placement, using random position." << std::endl;
-                    new_position = {disLat(global::gen), disLng(global::gen), disAlt(global::gen)};
-                }
-                
+            // Strategy 2: Add gateway near unconnected device cluster
+            if(new_position.lat == 0.0 && new_position.lng == 0.0)
+                new_position = findOptimalGatewayPosition();
+
+            // Strategy 3: If previous strategies fail, use random position
+            if(new_position.lat == 0.0 && new_position.lng == 0.0) {
+                *log << "No unconnected devices found for optimal placement, using random position." << std::endl;
+                new_position = randomPosition();
+            }
+            
+            stagnant_iterations = 0; // Reset stagnation counter
+            if(network.getSiteConstraints().snap(new_position)) {
                 network.addGateway(new_position);
                 gateways_added++;
-                stagnant_iterations = 0; // Reset stagnation counter
                 
-                global::dbg << "Added gateway #" << gateways_added 
+                *log << "Added gateway #" << gateways_added 
                           << " at iteration " << iter 
                           << " (lat: " << new_position.lat 
                           << ", lng: " << new_position.lng 
                           << ", alt: " << new_position.alt << ")" << std::endl;
-                
-                // Resize velocities vector for new gateway
-                velocities.resize(network.getGateways().size());
+            } else {
+                snap_failures++;
+                *log << "No permitted site for a new gateway at iteration " << iter << std::endl;
             }
-        } else {
-            global::dbg << "System still moving -> next iteration." << std::endl;
-            stagnant_iterations = 0; // Reset if movement detected            
         }
-        
-        // Break if velocity is extremely low and no more gateways to add
-        if(avg_velocity < STAGNATION_THRESHOLD && gateways_added >= MAX_GATEWAYS_TO_ADD) {
-            global::dbg << "Maximum gateways added and system stagnated at iteration " << iter << std::endl;
-            break;
+    } else {
+        *log << "System still moving -> next iteration." << std::endl;
+        stagnant_iterations = 0; // Reset if movement detected            
+    }
+    
+    // Break if velocity is extremely low and no more gateways to add
+    if(avg_velocity < STAGNATION_THRESHOLD && gateways_added >= MAX_GATEWAYS_TO_ADD) {
+        *log << "Maximum gateways added and system stagnated at iteration " << iter << std::endl;
+        stop_reason = optimizer::CONVERGED;
+        return false;
+    }
+
+    if(!checkpoint_file.empty() && checkpoint_interval > 0 && iteration % checkpoint_interval == 0)
+        saveCheckpoint(checkpoint_file);
+
+    return true;
+};
+
+void AttractorOptimizer::saveCheckpoint(const std::string& filepath) const {
+    // Written next to the target and renamed, so an interrupted write keeps the previous checkpoint
+    const std::string tmp_path = filepath + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::binary);
+        if(!file.is_open())
+            throw std::runtime_error("Could not open file for writing: " + tmp_path);
+
+        file.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+        writeValue(file, CHECKPOINT_VERSION);
+        writeValue(file, coverage::CoverageMatrix::fingerprintOf(network, {})); // End device positions
+        writeValue<std::uint32_t>(file, max_iterations);
+        writeValue<std::uint32_t>(file, iteration);
+        writeValue<std::int32_t>(file, stagnant_iterations);
+        writeValue<std::int32_t>(file, gateways_added);
+        writeValue<std::uint8_t>(file, stop_reason);
+        writeGenerator(file, gen);
+        writeGenerator(file, network.getIdGenerator());
+        writeGateways(file, network);
+
+        writeValue<std::uint8_t>(file, best_state ? 1 : 0);
+        if(best_state) {
+            writeValue<std::uint64_t>(file, best_score.connected);
+            writeValue<std::uint64_t>(file, best_score.gateways);
+            writeValue(file, best_score.distance);
+            writeGateways(file, *best_state);
         }
+        if(!file)
+            throw std::runtime_error("Could not write checkpoint file: " + tmp_path);
+    }
+    if(std::rename(tmp_path.c_str(), filepath.c_str()) != 0)
+        throw std::runtime_error("Could not write checkpoint file: " + filepath);
+};
+
+void AttractorOptimizer::resume(const std::string& filepath, unsigned int maxIterations) {
+    std::ifstream file(filepath, std::ios::binary);
+    if(!file.is_open())
+        throw std::runtime_error("Could not open checkpoint file: " + filepath);
+
+    char magic[4];
+    file.read(magic, sizeof(magic));
+    const auto version = readValue<std::uint32_t>(file);
+    if(!file || std::memcmp(magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0 || version != CHECKPOINT_VERSION)
+        throw std::runtime_error("Invalid checkpoint file: " + filepath);
+    if(readValue<std::uint64_t>(file) != coverage::CoverageMatrix::fingerprintOf(network, {}))
+        throw std::runtime_error("Checkpoint file does not match the end devices of the network: " + filepath);
+
+    readValue<std::uint32_t>(file); // Iteration limit of the previous run
+    iteration = readValue<std::uint32_t>(file);
+    stagnant_iterations = readValue<std::int32_t>(file);
+    gateways_added = readValue<std::int32_t>(file);
+    const auto stopped = static_cast<optimizer::STOP_REASON>(readValue<std::uint8_t>(file));
+    if(stopped > optimizer::TIME_LIMIT)
+        throw std::runtime_error("Invalid checkpoint file: " + filepath);
+    gen = readGenerator(file);
+    const rng::Philox id_gen = readGenerator(file);
+
+    std::vector<std::string> ids;
+    std::vector<terrain::LatLngAlt> positions;
+    readGateways(file, ids, positions);
+
+    best_state.reset();
+    if(readValue<std::uint8_t>(file) == 1) {
+        best_score.connected = readValue<std::uint64_t>(file);
+        best_score.gateways = readValue<std::uint64_t>(file);
+        best_score.distance = readValue<double>(file);
+        std::vector<std::string> best_ids;
+        std::vector<terrain::LatLngAlt> best_positions;
+        readGateways(file, best_ids, best_positions);
+        network.setGateways(best_ids, best_positions);
+        network.connect();
+        best_state = std::make_unique<network::Network>(network);
     }
+    if(!file)
+        throw std::runtime_error("Truncated checkpoint file: " + filepath);
+
+    network.setGateways(ids, positions);
+    network.setIdGenerator(id_gen);
+
+    max_iterations = maxIterations;
+    // A converged run stays finished, the limits are those of the new run
+    stop_reason = stopped == optimizer::CONVERGED ? optimizer::CONVERGED : optimizer::NOT_STOPPED;
+    startTelemetry();
+
+    *log << "Resumed from checkpoint at iteration " << iteration << " with " 
+                << ids.size() << " gateways" << std::endl;
+    if(stop_reason == optimizer::CONVERGED)
+        *log << "The checkpointed run had already converged" << std::endl;
+};
+
+void AttractorOptimizer::finish() {
+    if(!checkpoint_file.empty()) // State of the run, before restoring the best one
+        saveCheckpoint(checkpoint_file);
 
-    return;
-};
\ No newline at end of file
+    network.connect();
+    if(best_state && best_score.betterThan(optimizer::Score::of(network), optimizer::MAX_COVERAGE)) {
+        *log << "Restoring best state (" << best_score.connected << " connected end devices)" << std::endl;
+        network = *best_state;
+    }
+    best_state.reset();
+
+    if(stop_reason == optimizer::NOT_STOPPED) // finish() called before step() returned false
+        stop_reason = deadlineReached() ? optimizer::TIME_LIMIT : optimizer::ITERATION_LIMIT;
+
+    record(iteration, optimizer::Score::of(network));
+    network.setProperty("optimization", {
+        {"algorithm", "attractor"},
+        {"iterations", iteration},
+        {"snap_failures", snap_failures},
+        {"stop_reason", optimizer::stopReasonName(stop_reason)},
+        {"elapsed_ms", getElapsed()}
+    });
+};
+
+void AttractorOptimizer::optimize(unsigned int maxIterations) {
+    start(maxIterations);
+    while(step());
+    finish();
+};
@@ -0,0 +1,265 @@
+#define MANUAL "assets/bench_locality_manual.txt"
+
+#include <iostream>
+#include <cstring>
+#include <chrono>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "../include/json.hpp"
+#include "../include/global.hpp"
+#include "../include/terrain.hpp"
+#include "../include/network.hpp"
+
+#define L1_CACHE_BYTES 32768 // Simulated caches
+#define L1_CACHE_WAYS 8
+#define L2_CACHE_BYTES 1048576
+#define L2_CACHE_WAYS 16
+#define CACHE_LINE_BYTES 64
+
+
+// Set associative cache with LRU replacement
+class CacheModel {
+public:
+    CacheModel(std::size_t bytes, std::size_t ways) 
+        : ways(ways), sets(bytes / CACHE_LINE_BYTES / ways), tags(sets * ways, ~0ull), stamps(sets * ways, 0) {};
+
+    bool access(std::uint64_t address) { // Returns true on hit
+        const std::uint64_t line = address / CACHE_LINE_BYTES;
+        const std::size_t first = (line % sets) * ways;
+        std::size_t victim = first;
+        clock++;
+        for(std::size_t w = first; w < first + ways; w++) {
+            if(tags[w] == line) {
+                stamps[w] = clock;
+                return true;
+            }
+            if(stamps[w] < stamps[victim]) victim = w;
+        }
+        tags[victim] = line;
+        stamps[victim] = clock;
+        misses++;
+        return false;
+    };
+    std::uint64_t misses = 0;
+
+private:
+    std::size_t ways, sets;
+    std::vector<std::uint64_t> tags, stamps;
+    std::uint64_t clock = 0;
+};
+
+struct Trace {
+    std::uint64_t accesses = 0, l1_misses = 0, l2_misses = 0;
+};
+
+// Replays the elevation cells read by connect(): for each end device in storage order, the line of sight
+// walk (with the same early exit) of every gateway in range that is closer than the best one so far
+Trace replayConnect(network::Network& net) {
+    const auto& grid = net.getElevationGrid();
+    const auto& gws = net.getGateways();
+    const auto& eds = net.getEndDevices();
+    CacheModel l1(L1_CACHE_BYTES, L1_CACHE_WAYS), l2(L2_CACHE_BYTES, L2_CACHE_WAYS);
+    Trace trace;
+
+    auto read = [&](double lat, double lng) {
+        for(std::size_t offset : grid.interpolationOffsets(lat, lng)) {
+            const std::uint64_t address = offset * sizeof(double);
+            trace.accesses++;
+            if(!l1.access(address)) l2.access(address);
+        }
+        return grid.bilinearInterpolation(lat, lng);
+    };
+
+    std::vector<projection::Point> gw_points;
+    for(const auto& gw : gws) gw_points.push_back(net.getFrame().project(gw.location));
+    for(const auto& ed : eds) {
+        const projection::Point point = net.getFrame().project(ed.location);
+        double min_dist = network::MAX_RANGE_SQUARED;
+        for(std::size_t g = 0; g < gws.size(); g++) {
+            const double distance = projection::squaredDistance(gw_points[g], point);
+            if(distance >= min_dist) continue;
+            const terrain::LatLngAlt& a = gws[g].location;
+            const terrain::LatLngAlt& b = ed.location;
+            const double elev1 = read(a.lat, a.lng) + a.alt;
+            const double elev2 = read(b.lat, b.lng) + b.alt;
+            bool clear = true;
+            for(int k = 1; k < SAMPLES_STEPS && clear; ++k) {
+                const double t = double(k) / SAMPLES_STEPS;
+                clear = !(read(a.lat + t * (b.lat - a.lat), a.lng + t * (b.lng - a.lng)) > elev1 + t * (elev2 - elev1));
+            }
+            if(clear) min_dist = distance;
+        }
+    }
+    trace.l1_misses = l1.misses;
+    trace.l2_misses = l2.misses;
+    return trace;
+};
+
+// Hardware cache misses of the calling thread, if the kernel exposes the counters
+class MissCounter {
+public:
+    MissCounter() {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.inherit = 1; // OpenMP threads created afterwards
+        fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+    };
+    ~MissCounter() { if(fd >= 0) close(fd); };
+    inline bool available() const { return fd >= 0; };
+    void start() {
+        if(fd < 0) return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    };
+    long long stop() {
+        if(fd < 0) return -1;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        long long count = 0;
+        if(read(fd, &count, sizeof(count)) != sizeof(count)) return -1;
+        return count;
+    };
+private:
+    int fd = -1;
+};
+
+int main(int argc, char **argv) {
+
+    std::string em_filename; // Terrain elevation model file (csv)
+    std::string nw_filename; // Network file (geojson)
+    int repeats = 5; // Timed connects per configuration
+    global::PRINT_TYPE outputFormat = global::PLAIN_TEXT;
+
+    for(int i = 0; i < argc; i++) {
+        if(strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0 || argc == 1)
+            global::printHelp(MANUAL);
+
+        if(strcmp(argv[i], "-f") == 0 || strcmp(argv[i], "--em_file") == 0) {
+            if(i+1 < argc) {
+                em_filename = std::string(argv[i+1]);
+            }else{
+                global::printHelp(MANUAL, "Error in argument -f (--em_file). A filename must be provided");
+            }
+        }
+
+        if(strcmp(argv[i], "-g") == 0 || strcmp(argv[i], "--nw_file") == 0) {
+            if(i+1 < argc) {
+                nw_filename = std::string(argv[i+1]);
+            }else{
+                global::printHelp(MANUAL, "Error in argument -g (--nw_file). A filename must be provided");
+            }
+        }
+
+        if(strcmp(argv[i], "-r") == 0 || strcmp(argv[i], "--repeat") == 0) {
+            if(i+1 < argc) {
+                repeats = atoi(argv[i+1]);
+                if(repeats < 1)
+                    global::printHelp(MANUAL, "Error in argument -r (--repeat). A positive integer number must be provided");
+            }else{
+                global::printHelp(MANUAL, "Error in argument -r (--repeat). An integer number must be provided");
+            }
+        }
+
+        if(strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--output") == 0) {
+            if(i+1 < argc) {
+                const char* fmt = argv[i+1];
+                if(strcmp(fmt, "text") == 0) {
+                    outputFormat = global::PLAIN_TEXT;
+                } else if(strcmp(fmt, "json") == 0) {
+                    outputFormat = global::JSON;
+                } else {
+                    global::printHelp(MANUAL, "Error in argument -o (--output). Supported formats: text, json");
+                }
+            } else {
+                global::printHelp(MANUAL, "Error in argument -o (--output)");
+            }
+        }
+    }
+
+    if(em_filename.empty()) {
+        global::printHelp(MANUAL, "Error in argument -f (--em_file). A filename must be provided.");
+    }
+    if(nw_filename.empty()) {
+        global::printHelp(MANUAL, "Error in argument -g (--nw_file). A filename must be provided.");
+    }
+
+    terrain::ElevationGrid rows = terrain::ElevationGrid::fromCSV(em_filename);
+    terrain::ElevationGrid tiles = rows;
+    tiles.setLayout(terrain::Z_ORDER_TILES);
+    const auto row_grid = std::make_shared<const terrain::ElevationGrid>(std::move(rows));
+    const auto tile_grid = std::make_shared<const terrain::ElevationGrid>(std::move(tiles));
+    const network::Network base = network::Network::fromGeoJSON(nw_filename);
+
+    MissCounter counter;
+    nlohmann::json results = nlohmann::json::array();
+    for(network::ED_ORDER order : {network::INPUT_ORDER, network::HILBERT_ORDER}) {
+        for(terrain::GRID_LAYOUT layout : {terrain::ROW_MAJOR, terrain::Z_ORDER_TILES}) {
+            network::Network net = base;
+            net.setElevationGrid(layout == terrain::ROW_MAJOR ? row_grid : tile_grid);
+            net.orderEndDevices(order);
+
+            net.connect(); // Warm up
+            double total_ms = 0.0;
+            long long misses = 0;
+            counter.start();
+            for(int r = 0; r < repeats; r++) {
+                const auto start = std::chrono::steady_clock::now();
+                net.connect();
+                total_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+            misses = counter.stop();
+
+            const Trace trace = replayConnect(net);
+            results.push_back({
+                {"order", order == network::INPUT_ORDER ? "input" : "hilbert"},
+                {"layout", layout == terrain::ROW_MAJOR ? "rows" : "tiles"},
+                {"connect_ms", total_ms / repeats},
+                {"hardware_misses", misses >= 0 ? nlohmann::json(misses / repeats) : nlohmann::json(nullptr)},
+                {"grid_reads", trace.accesses},
+                {"l1_misses", trace.l1_misses},
+                {"l2_misses", trace.l2_misses},
+                {"connected", net.getConnectedEdCount()},
+                {"total_distance", net.getTotalDistance()}
+            });
+        }
+    }
+
+    switch(outputFormat) {
+        case global::PLAIN_TEXT:
+            std::cout << "Simulated caches: L1 " << L1_CACHE_BYTES / 1024 << " KiB " << L1_CACHE_WAYS << "-way, L2 " 
+                      << L2_CACHE_BYTES / 1024 << " KiB " << L2_CACHE_WAYS << "-way, " << CACHE_LINE_BYTES << " B lines" << std::endl;
+            if(!counter.available())
+                std::cout << "Hardware cache counters not available" << std::endl;
+            std::cout << "order,layout,connect_ms,hardware_misses,grid_reads,l1_misses,l2_misses,connected,total_distance" << std::endl;
+            for(const auto& row : results) {
+                std::cout << row["order"].get<std::string>() << ","
+                          << row["layout"].get<std::string>() << ","
+                          << row["connect_ms"] << ","
+                          << (row["hardware_misses"].is_null() ? "n/a" : row["hardware_misses"].dump()) << ","
+                          << row["grid_reads"] << ","
+                          << row["l1_misses"] << ","
+                          << row["l2_misses"] << ","
+                          << row["connected"] << ","
+                          << row["total_distance"] << std::endl;
+            }
+            break;
+        case global::JSON:
+            std::cout << nlohmann::json{
+                {"caches", {{"l1_bytes", L1_CACHE_BYTES}, {"l1_ways", L1_CACHE_WAYS}, {"l2_bytes", L2_CACHE_BYTES}, {"l2_ways", L2_CACHE_WAYS}, {"line_bytes", CACHE_LINE_BYTES}}},
+                {"results", results}
+            }.dump(2) << std::endl;
+            break;
+        default:
+            break;
+    }
+
+    return 0;
+}
@@ -0,0 +1,268 @@
+#define MANUAL "assets/bench_optimizers_manual.txt"
+
+#include <iostream>
+#include <cstring>
+#include <chrono>
+#include <sstream>
+#include <map>
+#include <cstdlib>
+#include <cerrno>
+
+#include "../include/json.hpp"
+#include "../include/global.hpp"
+#include "../include/terrain.hpp"
+#include "../include/network.hpp"
+#include "../include/registry.hpp"
+
+
+struct Run {
+    std::string instance;
+    std::uint64_t seed;
+    std::size_t end_devices;
+    double wall_ms; // Includes the setup of the optimizer (e.g. the coverage matrix)
+    optimizer::Result result;
+};
+
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    std::string item;
+    while(std::getline(ss, item, ','))
+        if(!item.empty()) items.push_back(item);
+    return items;
+}
+
+int main(int argc, char **argv) {
+
+    std::string em_filename; // Terrain elevation model file (csv)
+    std::vector<std::string> instances; // Network files (geojson)
+    std::vector<std::string> names; // Algorithms to run, all the registered ones if empty
+    int iterations = 0; // Budget of every algorithm, 0 for their defaults
+    double time_limit = 30.0; // Seconds per run
+    int repeats = 1; // Runs per instance and algorithm, with consecutive seeds
+    std::uint64_t seed = 1;
+
+    global::PRINT_TYPE outputFormat = global::PLAIN_TEXT;
+
+    for(int i = 0; i < argc; i++) {
+        if(strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0 || argc == 1)
+            global::printHelp(MANUAL);
+
+        if(strcmp(argv[i], "-f") == 0 || strcmp(argv[i], "--em_file") == 0) {
+            if(i+1 < argc) {
+                em_filename = std::string(argv[i+1]);
+            }else{
+                global::printHelp(MANUAL, "Error in argument -f (--em_file). A filename must be provided");
+            }
+        }
+
+        if(strcmp(argv[i], "-g") == 0 || strcmp(argv[i], "--nw_file") == 0) {
+            if(i+1 < argc) {
+                instances.push_back(std::string(argv[i+1]));
+            }else{
+                global::printHelp(MANUAL, "Error in argument -g (--nw_file). A filename must be provided");
+            }
+        }
+
+        if(strcmp(argv[i], "-b") == 0 || strcmp(argv[i], "--batch") == 0) {
+            if(i+1 < argc) {
+                for(const auto& file : global::readManifest(argv[i+1]))
+                    instances.push_back(file);
+            }else{
+                global::printHelp(MANUAL, "Error in argument -b (--batch). A manifest file must be provided");
+            }
+        }
+
+        if(strcmp(argv[i], "-a") == 0 || strcmp(argv[i], "--algorithms") == 0) {
+            if(i+1 < argc) {
+                names = splitList(argv[i+1]);
+                for(const auto& name : names) {
+                    if(optimizer::findAlgorithm(name) == nullptr)
+                        global::printHelp(MANUAL, ("Error in argument -a (--algorithms). Supported algorithms: " + optimizer::algorithmNames()).c_str());
+                }
+            }else{
+                global::printHelp(MANUAL, "Error in argument -a (--algorithms). A comma separated list of algorithms must be provided");
+            }
+        }
+
+        if(strcmp(argv[i], "-i") == 0 || strcmp(argv[i], "--iters") == 0) {
+            if(i+1 < argc) {
+                iterations = atoi(argv[i+1]);
+                if(iterations < 1)
+                    global::printHelp(MANUAL, "Error in argument -i (--iters). A positive integer number must be provided");
+            }else{
+                global::printHelp(MANUAL, "Error in argument -i (--iters). An integer number must be provided");
+            }
+        }
+
+        if(strcmp(argv[i], "--time-limit") == 0) {
+            if(i+1 < argc) {
+                time_limit = atof(argv[i+1]);
+                if(time_limit <= 0.0)
+                    global::printHelp(MANUAL, "Error in argument --time-limit. A positive number of seconds must be provided");
+            }else{
+                global::printHelp(MANUAL, "Error in argument --time-limit. A number of seconds must be provided");
+            }
+        }
+
+        if(strcmp(argv[i], "-r") == 0 || strcmp(argv[i], "--repeat") == 0) {
+            if(i+1 < argc) {
+                repeats = atoi(argv[i+1]);
+                if(repeats < 1)
+                    global::printHelp(MANUAL, "Error in argument -r (--repeat). A positive integer number must be provided");
+            }else{
+                global::printHelp(MANUAL, "Error in argument -r (--repeat). An integer number must be provided");
+            }
+        }
+
+        if(strcmp(argv[i], "--seed") == 0) {
+            if(i+1 < argc) {
+                char* end = nullptr;
+                errno = 0;
+                seed = std::strtoull(argv[i+1], &end, 10);
+                if(end == argv[i+1] || *end != '\0' || errno == ERANGE || argv[i+1][0] == '-')
+                    global::printHelp(MANUAL, "Error in argument --seed. A non-negative integer number must be provided");
+            }else{
+                global::printHelp(MANUAL, "Error in argument --seed. An integer number must be provided");
+            }
+        }
+
+        if(strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--output") == 0) {
+            if(i+1 < argc) {
+                const char* fmt = argv[i+1];
+                if(strcmp(fmt, "text") == 0) {
+                    outputFormat = global::PLAIN_TEXT;
+                } else if(strcmp(fmt, "json") == 0) {
+                    outputFormat = global::JSON;
+                } else {
+                    global::printHelp(MANUAL, "Error in argument -o (--output). Supported formats: text, json");
+                }
+            } else {
+                global::printHelp(MANUAL, "Error in argument -o (--output)");
+            }
+        }
+
+        if(strcmp(argv[i], "--dbg") == 0) {
+            global::dbg.rdbuf(std::cerr.rdbuf()); // Debug output to std::cerr, so the results can be redirected
+        }
+    }
+
+    if(em_filename.empty()) {
+        global::printHelp(MANUAL, "Error in argument -f (--em_file). A filename must be provided.");
+    }
+    if(instances.empty()) {
+        global::printHelp(MANUAL, "Error in arguments -g (--nw_file) or -b (--batch). At least one network file must be provided.");
+    }
+    if(names.empty()) {
+        for(const auto& algorithm : optimizer::algorithms())
+            names.push_back(algorithm.name);
+    }
+
+    const auto grid = std::make_shared<const terrain::ElevationGrid>(terrain::ElevationGrid::fromCSV(em_filename));
+
+    // Runs are sequential so the timings are not affected by each other, every optimizer uses all the threads
+    std::vector<Run> runs;
+    for(const auto& instance : instances) {
+        network::Network base = network::Network::fromGeoJSON(instance);
+        base.setElevationGrid(grid);
+        for(const auto& name : names) {
+            for(int r = 0; r < repeats; r++) {
+                rng::setSeed(seed + r);
+                network::Network net = base;
+                net.setIdGenerator(rng::stream(rng::NODE_ID_STREAM)); // Ids of added gateways from the seed of the run
+
+                optimizer::Parameters params;
+                params.iterations = iterations;
+                const auto start = std::chrono::steady_clock::now();
+                params.deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(time_limit));
+
+                global::dbg << "Running " << name << " on " << instance << " (seed " << seed + r << ")" << std::endl;
+                optimizer::Result result = optimizer::run(name, net, params);
+                const double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                runs.push_back({instance, seed + r, net.getEndDevices().size(), wall_ms, result});
+            }
+        }
+    }
+
+    // Averages per instance and algorithm
+    struct Summary {
+        int runs = 0;
+        double wall_ms = 0.0, evaluations_per_second = 0.0, gateways = 0.0, coverage = 0.0, distance = 0.0;
+    };
+    std::map<std::pair<std::string, std::string>, Summary> summaries;
+    nlohmann::json rows = nlohmann::json::array();
+    for(const auto& run : runs) {
+        const double coverage = run.end_devices > 0 ? double(run.result.score.connected) / run.end_devices : 0.0;
+        nlohmann::json row = run.result.toJSON();
+        row["instance"] = run.instance;
+        row["seed"] = run.seed;
+        row["wall_ms"] = run.wall_ms;
+        row["end_devices"] = run.end_devices;
+        row["coverage"] = coverage;
+        rows.push_back(row);
+
+        Summary& s = summaries[{run.instance, run.result.algorithm}];
+        s.runs++;
+        s.wall_ms += run.wall_ms;
+        s.evaluations_per_second += run.result.evaluationsPerSecond();
+        s.gateways += run.result.score.gateways;
+        s.coverage += coverage;
+        s.distance += run.result.score.distance;
+    }
+    nlohmann::json summary = nlohmann::json::array();
+    for(const auto& instance : instances) {
+        for(const auto& name : names) {
+            const Summary& s = summaries[{instance, name}];
+            if(s.runs == 0) continue;
+            summary.push_back({
+                {"instance", instance},
+                {"algorithm", name},
+                {"runs", s.runs},
+                {"wall_ms", s.wall_ms / s.runs},
+                {"evaluations_per_second", s.evaluations_per_second / s.runs},
+                {"gateways", s.gateways / s.runs},
+                {"coverage", s.coverage / s.runs},
+                {"distance", s.distance / s.runs}
+            });
+        }
+    }
+
+    switch(outputFormat) {
+        case global::PLAIN_TEXT:
+            std::cout << "instance,algorithm,seed,wall_ms,evaluations,evaluations_per_second,gateways,connected,end_devices,coverage,distance,stop_reason" << std::endl;
+            for(const auto& row : rows) {
+                std::cout << row["instance"].get<std::string>() << ","
+                          << row["algorithm"].get<std::string>() << ","
+                          << row["seed"] << ","
+                          << row["wall_ms"] << ","
+                          << row["evaluations"] << ","
+                          << row["evaluations_per_second"] << ","
+                          << row["gateways"] << ","
+                          << row["connected"] << ","
+                          << row["end_devices"] << ","
+                          << row["coverage"] << ","
+                          << row["distance"] << ","
+                          << row["stop_reason"].get<std::string>() << std::endl;
+            }
+            std::cout << std::endl << "Summary (mean of the runs):" << std::endl;
+            std::cout << "instance,algorithm,runs,wall_ms,evaluations_per_second,gateways,coverage,distance" << std::endl;
+            for(const auto& row : summary) {
+                std::cout << row["instance"].get<std::string>() << ","
+                          << row["algorithm"].get<std::string>() << ","
+                          << row["runs"] << ","
+                          << row["wall_ms"] << ","
+                          << row["evaluations_per_second"] << ","
+                          << row["gateways"] << ","
+                          << row["coverage"] << ","
+                          << row["distance"] << std::endl;
+            }
+            break;
+        case global::JSON:
+            std::cout << nlohmann::json{{"runs", rows}, {"summary", summary}}.dump(2) << std::endl;
+            break;
+        default:
+            break;
+    }
+
+    return 0;
+}
@@ -0,0 +1,283 @@
+#include "../include/clustering.hpp"
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+namespace clustering {
+
+namespace {
+
+// Equirectangular projection (meters) around a reference point
+struct Projection {
+    double lat0 = 0.0, lng0 = 0.0, kx = 0.0, ky = 0.0;
+
+    explicit Projection(const std::vector<terrain::LatLngAlt>& points) {
+        for(const auto& p : points) {
+            lat0 += p.lat;
+            lng0 += p.lng;
+        }
+        if(!points.empty()) {
+            lat0 /= points.size();
+            lng0 /= points.size();
+        }
+        ky = terrain::EARTH_RADIUS * M_PI / 180.0;
+        kx = ky * std::cos(lat0 * M_PI / 180.0);
+    };
+
+    inline double x(const terrain::LatLngAlt& p) const { return (p.lng - lng0) * kx; };
+    inline double y(const terrain::LatLngAlt& p) const { return (p.lat - lat0) * ky; };
+    inline terrain::LatLngAlt toLatLng(double x, double y, double alt) const { return {lat0 + y / ky, lng0 + x / kx, alt}; };
+};
+
+inline double squared(double dx, double dy) { return dx * dx + dy * dy; }
+
+// Largest distance from a point to its closest center (meters)
+double coverRadius(const std::vector<terrain::LatLngAlt>& points, const std::vector<terrain::LatLngAlt>& centers) {
+    const Projection proj(points);
+    double worst = 0.0;
+    #pragma omp parallel for reduction(max:worst)
+    for(std::size_t i = 0; i < points.size(); i++) {
+        double best = std::numeric_limits<double>::infinity();
+        for(const auto& c : centers)
+            best = std::min(best, squared(proj.x(points[i]) - proj.x(c), proj.y(points[i]) - proj.y(c)));
+        worst = std::max(worst, best);
+    }
+    return std::sqrt(worst);
+};
+
+} // namespace
+
+std::vector<terrain::LatLngAlt> kMeans(const std::vector<terrain::LatLngAlt>& points,
+                                       std::size_t k,
+                                       rng::Philox& gen,
+                                       unsigned int iterations) {
+    const std::size_t n = points.size();
+    k = std::min(k, n);
+    if(k == 0)
+        return {};
+
+    const Projection proj(points);
+    std::vector<double> xs(n), ys(n);
+    for(std::size_t i = 0; i < n; i++) {
+        xs[i] = proj.x(points[i]);
+        ys[i] = proj.y(points[i]);
+    }
+
+    // k-means++ seeding: next center drawn with probability proportional to the squared distance to the closest one
+    std::vector<double> cx, cy;
+    std::uniform_int_distribution<std::size_t> any_point(0, n - 1);
+    const std::size_t first = any_point(gen);
+    cx.push_back(xs[first]);
+    cy.push_back(ys[first]);
+
+    std::vector<double> d2(n, std::numeric_limits<double>::infinity());
+    while(cx.size() < k) {
+        const double lx = cx.back(), ly = cy.back();
+        #pragma omp parallel for schedule(static)
+        for(std::size_t i = 0; i < n; i++)
+            d2[i] = std::min(d2[i], squared(xs[i] - lx, ys[i] - ly));
+
+        double total = 0.0;
+        for(double d : d2) total += d;
+        if(total <= 0.0) break; // Every point is already a center
+
+        std::uniform_real_distribution<double> uniform(0.0, total);
+        double target = uniform(gen);
+        std::size_t next = n - 1;
+        for(std::size_t i = 0; i < n; i++) {
+            target -= d2[i];
+            if(target <= 0.0 && d2[i] > 0.0) {
+                next = i;
+                break;
+            }
+        }
+        cx.push_back(xs[next]);
+        cy.push_back(ys[next]);
+    }
+    k = cx.size();
+
+    // Lloyd iterations
+    std::vector<std::size_t> labels(n, k);
+    std::vector<double> sum_x(k), sum_y(k), sum_alt(k);
+    std::vector<std::size_t> count(k);
+    for(unsigned int it = 0; it < std::max(1u, iterations); it++) {
+        std::size_t changed = 0;
+        #pragma omp parallel for schedule(static) reduction(+:changed)
+        for(std::size_t i = 0; i < n; i++) {
+            std::size_t best = 0;
+            double best_d = std::numeric_limits<double>::infinity();
+            for(std::size_t c = 0; c < k; c++) {
+                const double d = squared(xs[i] - cx[c], ys[i] - cy[c]);
+                if(d < best_d) {
+                    best_d = d;
+                    best = c;
+                }
+            }
+            if(labels[i] != best) {
+                labels[i] = best;
+                changed++;
+            }
+        }
+
+        std::fill(sum_x.begin(), sum_x.end(), 0.0);
+        std::fill(sum_y.begin(), sum_y.end(), 0.0);
+        std::fill(sum_alt.begin(), sum_alt.end(), 0.0);
+        std::fill(count.begin(), count.end(), 0);
+        for(std::size_t i = 0; i < n; i++) { // In order, so the sums do not depend on the threads
+            sum_x[labels[i]] += xs[i];
+            sum_y[labels[i]] += ys[i];
+            sum_alt[labels[i]] += points[i].alt;
+            count[labels[i]]++;
+        }
+        if(changed == 0) break;
+        for(std::size_t c = 0; c < k; c++) {
+            if(count[c] == 0) continue; // Empty cluster keeps its center
+            cx[c] = sum_x[c] / count[c];
+            cy[c] = sum_y[c] / count[c];
+        }
+    }
+
+    std::vector<terrain::LatLngAlt> centers;
+    centers.reserve(k);
+    for(std::size_t c = 0; c < k; c++)
+        centers.push_back(proj.toLatLng(cx[c], cy[c], count[c] > 0 ? sum_alt[c] / count[c] : 0.0));
+    return centers;
+};
+
+std::vector<terrain::LatLngAlt> kMeansForRange(const std::vector<terrain::LatLngAlt>& points,
+                                               double radius,
+                                               rng::Philox& gen) {
+    if(points.empty())
+        return {};
+
+    // Double k until the clusters are small enough, then bisect
+    std::size_t k = 1;
+    std::vector<terrain::LatLngAlt> best = kMeans(points, k, gen);
+    while(coverRadius(points, best) > radius && k < points.size()) {
+        k = std::min(points.size(), 2 * k);
+        best = kMeans(points, k, gen);
+    }
+
+    std::size_t lo = k / 2, hi = k; // lo fails (or is zero), hi fits
+    while(hi - lo > 1) {
+        const std::size_t mid = (lo + hi) / 2;
+        std::vector<terrain::LatLngAlt> centers = kMeans(points, mid, gen);
+        if(coverRadius(points, centers) <= radius) {
+            hi = mid;
+            best = std::move(centers);
+        } else {
+            lo = mid;
+        }
+    }
+    return best;
+};
+
+std::vector<std::size_t> kMedoids(const network::Network& net,
+                                  const coverage::CoverageMatrix& matrix,
+                                  const std::vector<std::size_t>& devices,
+                                  const std::vector<terrain::LatLngAlt>& centers,
+                                  unsigned int iterations) {
+    const auto& sites = matrix.getSites();
+    const std::size_t k = centers.size();
+    if(sites.empty() || k == 0 || devices.empty())
+        return {};
+
+    std::vector<terrain::LatLngAlt> locations;
+    for(std::size_t e : devices)
+        locations.push_back(net.getEndDevices()[e].location);
+    const Projection proj(locations);
+
+    std::vector<double> sx(sites.size()), sy(sites.size());
+    for(std::size_t s = 0; s < sites.size(); s++) {
+        sx[s] = proj.x(sites[s]);
+        sy[s] = proj.y(sites[s]);
+    }
+    std::vector<double> dx(devices.size()), dy(devices.size());
+    for(std::size_t i = 0; i < devices.size(); i++) {
+        dx[i] = proj.x(locations[i]);
+        dy[i] = proj.y(locations[i]);
+    }
+
+    // Closest site to each center
+    std::vector<std::size_t> medoids(k);
+    #pragma omp parallel for schedule(static)
+    for(std::size_t c = 0; c < k; c++) {
+        const double x = proj.x(centers[c]), y = proj.y(centers[c]);
+        double best_d = std::numeric_limits<double>::infinity();
+        for(std::size_t s = 0; s < sites.size(); s++) {
+            const double d = squared(sx[s] - x, sy[s] - y);
+            if(d < best_d) {
+                best_d = d;
+                medoids[c] = s;
+            }
+        }
+    }
+
+    std::vector<std::size_t> labels(devices.size());
+    std::vector<coverage::DeviceSet> members(k, coverage::DeviceSet(matrix.getNumDevices()));
+    std::vector<double> mx(k), my(k);
+    std::vector<std::size_t> count(k);
+
+    for(unsigned int it = 0; it < std::max(1u, iterations); it++) {
+        // Closest medoid reaching the device, or closest one if none does
+        #pragma omp parallel for schedule(static)
+        for(std::size_t i = 0; i < devices.size(); i++) {
+            double best_reach = std::numeric_limits<double>::infinity(), best_any = best_reach;
+            std::size_t reach = k, any = 0;
+            for(std::size_t c = 0; c < k; c++) {
+                const double d = squared(sx[medoids[c]] - dx[i], sy[medoids[c]] - dy[i]);
+                if(d < best_any) {
+                    best_any = d;
+                    any = c;
+                }
+                if(d < best_reach && matrix.covers(medoids[c], devices[i])) {
+                    best_reach = d;
+                    reach = c;
+                }
+            }
+            labels[i] = reach < k ? reach : any;
+        }
+
+        for(std::size_t c = 0; c < k; c++) {
+            members[c] = coverage::DeviceSet(matrix.getNumDevices());
+            mx[c] = my[c] = 0.0;
+            count[c] = 0;
+        }
+        for(std::size_t i = 0; i < devices.size(); i++) {
+            members[labels[i]].set(devices[i]);
+            mx[labels[i]] += dx[i];
+            my[labels[i]] += dy[i];
+            count[labels[i]]++;
+        }
+
+        // Site reaching most devices of the cluster, closest to its centroid on ties
+        std::size_t changed = 0;
+        #pragma omp parallel for schedule(dynamic) reduction(+:changed)
+        for(std::size_t c = 0; c < k; c++) {
+            if(count[c] == 0) continue;
+            const double x = mx[c] / count[c], y = my[c] / count[c];
+            std::size_t best = medoids[c], best_reach = 0;
+            double best_d = std::numeric_limits<double>::infinity();
+            for(std::size_t s = 0; s < sites.size(); s++) {
+                const std::size_t reach = coverage::bits::popcountAnd(matrix.row(s), members[c].data(), matrix.getNumWords());
+                const double d = squared(sx[s] - x, sy[s] - y);
+                if(reach > best_reach || (reach == best_reach && d < best_d)) {
+                    best = s;
+                    best_reach = reach;
+                    best_d = d;
+                }
+            }
+            if(best != medoids[c]) {
+                medoids[c] = best;
+                changed++;
+            }
+        }
+        if(changed == 0) break;
+    }
+
+    std::sort(medoids.begin(), medoids.end());
+    medoids.erase(std::unique(medoids.begin(), medoids.end()), medoids.end());
+    return medoids;
+};
+
+} // namespace clustering
@@ -0,0 +1,31 @@
+#include "../include/coverage.hpp"
+#include <algorithm>
+
+namespace coverage {
+
+std::vector<terrain::LatLngAlt> candidateSites(const network::Network& net, double spacing, double height) {
+    const std::vector<double> bbox = net.getBoundingBox(); // minLng, minLat, maxLng, maxLat
+    const auto grid_bbox = net.getElevationGrid().getBoundingBox();
+
+    const double minLat = std::max(bbox[1], grid_bbox[0].lat), maxLat = std::min(bbox[3], grid_bbox[2].lat);
+    const double minLng = std::max(bbox[0], grid_bbox[0].lng), maxLng = std::min(bbox[2], grid_bbox[2].lng);
+
+    std::vector<terrain::LatLngAlt> sites;
+    if(minLat > maxLat || minLng > maxLng)
+        return sites;
+
+    // Lattice step in degrees at the center of the box
+    const double lat_step = spacing / terrain::EARTH_RADIUS * 180.0 / M_PI;
+    const double lng_step = lat_step / std::cos(global::toRadians((minLat + maxLat) / 2));
+
+    const zones::SiteConstraints& constraints = net.getSiteConstraints();
+    for(double lat = minLat; lat <= maxLat; lat += lat_step) {
+        for(double lng = minLng; lng <= maxLng; lng += lng_step) {
+            if(constraints.permits({lat, lng, height}))
+                sites.push_back({lat, lng, height});
+        }
+    }
+    return sites;
+};
+
+} // namespace coverage
@@ -0,0 +1,286 @@
+#include "../include/coverage_matrix.hpp"
+#include <fstream>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define COVERAGE_X86 1
+#endif
+
+namespace coverage {
+
+namespace bits {
+
+#ifdef COVERAGE_X86
+
+// Nibble lookup popcount (Mula et al.): vpshufb counts 4 bits at a time, vpsadbw sums the bytes
+__attribute__((target("avx2")))
+static inline __m256i popcount256(__m256i v) {
+    const __m256i lookup = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,
+                                            0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+    const __m256i lo = _mm256_and_si256(v, low_mask);
+    const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    const __m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+    return _mm256_sad_epu8(cnt, _mm256_setzero_si256());
+}
+
+__attribute__((target("avx2")))
+static inline std::size_t horizontalSum(__m256i acc) {
+    return static_cast<std::size_t>(_mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1) +
+                                    _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3));
+}
+
+// op: 0 = a, 1 = a & b, 2 = a & ~b
+template <int op>
+__attribute__((target("avx2")))
+static std::size_t popcountAVX2(const std::uint64_t* a, const std::uint64_t* b, std::size_t words) {
+    __m256i acc = _mm256_setzero_si256();
+    for (std::size_t i = 0; i < words; i += 4) {
+        __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(a + i));
+        if (op == 1) v = _mm256_and_si256(v, _mm256_load_si256(reinterpret_cast<const __m256i*>(b + i)));
+        if (op == 2) v = _mm256_andnot_si256(_mm256_load_si256(reinterpret_cast<const __m256i*>(b + i)), v);
+        acc = _mm256_add_epi64(acc, popcount256(v));
+    }
+    return horizontalSum(acc);
+}
+
+__attribute__((target("avx2")))
+static void orIntoAVX2(std::uint64_t* dst, const std::uint64_t* src, std::size_t words) {
+    for (std::size_t i = 0; i < words; i += 4) {
+        __m256i* d = reinterpret_cast<__m256i*>(dst + i);
+        _mm256_store_si256(d, _mm256_or_si256(_mm256_load_si256(d), _mm256_load_si256(reinterpret_cast<const __m256i*>(src + i))));
+    }
+}
+
+__attribute__((target("avx2")))
+static void andNotIntoAVX2(std::uint64_t* dst, const std::uint64_t* src, std::size_t words) {
+    for (std::size_t i = 0; i < words; i += 4) {
+        __m256i* d = reinterpret_cast<__m256i*>(dst + i);
+        _mm256_store_si256(d, _mm256_andnot_si256(_mm256_load_si256(reinterpret_cast<const __m256i*>(src + i)), _mm256_load_si256(d)));
+    }
+}
+
+bool hasAVX2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+#else
+
+bool hasAVX2() { return false; }
+
+#endif
+
+std::size_t popcount(const std::uint64_t* a, std::size_t words) {
+#ifdef COVERAGE_X86
+    if (hasAVX2()) return popcountAVX2<0>(a, nullptr, words);
+#endif
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < words; ++i) count += __builtin_popcountll(a[i]);
+    return count;
+}
+
+std::size_t popcountAnd(const std::uint64_t* a, const std::uint64_t* b, std::size_t words) {
+#ifdef COVERAGE_X86
+    if (hasAVX2()) return popcountAVX2<1>(a, b, words);
+#endif
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < words; ++i) count += __builtin_popcountll(a[i] & b[i]);
+    return count;
+}
+
+std::size_t popcountAndNot(const std::uint64_t* a, const std::uint64_t* b, std::size_t words) {
+#ifdef COVERAGE_X86
+    if (hasAVX2()) return popcountAVX2<2>(a, b, words);
+#endif
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < words; ++i) count += __builtin_popcountll(a[i] & ~b[i]);
+    return count;
+}
+
+void orInto(std::uint64_t* dst, const std::uint64_t* src, std::size_t words) {
+#ifdef COVERAGE_X86
+    if (hasAVX2()) return orIntoAVX2(dst, src, words);
+#endif
+    for (std::size_t i = 0; i < words; ++i) dst[i] |= src[i];
+}
+
+void andNotInto(std::uint64_t* dst, const std::uint64_t* src, std::size_t words) {
+#ifdef COVERAGE_X86
+    if (hasAVX2()) return andNotIntoAVX2(dst, src, words);
+#endif
+    for (std::size_t i = 0; i < words; ++i) dst[i] &= ~src[i];
+}
+
+} // namespace bits
+
+
+CoverageMatrix::CoverageMatrix(const std::vector<terrain::LatLngAlt>& sites, std::size_t devices) 
+    : sites(sites), devices(devices), stride(paddedWords(devices)), rows(sites.size() * stride, 0) {};
+
+CoverageMatrix CoverageMatrix::build(const network::Network& net, const std::vector<terrain::LatLngAlt>& sites) {
+    const auto& grid = net.getElevationGrid();
+    const auto& eds = net.getEndDevices();
+    CoverageMatrix matrix(sites, eds.size());
+    matrix.fingerprint = fingerprintOf(net, sites);
+    std::vector<terrain::LatLngAlt> positions;
+    for (const auto& ed : eds) positions.push_back(ed.location);
+    const std::vector<projection::Point> ed_points = net.getFrame().project(positions);
+    const auto& representative = net.getRepresentatives();
+
+    #pragma omp parallel for schedule(dynamic) // parallelize over sites, each thread writes its own rows
+    for (int s = 0; s < static_cast<int>(sites.size()); s++) {
+        const projection::Point site = net.getFrame().project(sites[s]);
+        for (std::size_t e = 0; e < eds.size(); e++) {
+            if (representative[e] != e) { // Co-located with an end device already checked
+                if (matrix.covers(s, representative[e])) matrix.set(s, e);
+                continue;
+            }
+            // Same criteria as Network::connect(), range check first
+            if (projection::squaredDistance(site, ed_points[e]) < network::MAX_RANGE_SQUARED && 
+                grid.lineOfSight(sites[s], eds[e].location)) {
+                matrix.set(s, e);
+            }
+        }
+    }
+    return matrix;
+};
+
+CoverageMatrix CoverageMatrix::fromSets(const std::vector<terrain::LatLngAlt>& sites, 
+                                        const std::vector<std::vector<std::uint32_t>>& sets, 
+                                        std::size_t devices) {
+    CoverageMatrix matrix(sites, devices);
+    #pragma omp parallel for schedule(static)
+    for (int s = 0; s < static_cast<int>(sets.size()); s++) {
+        for (std::uint32_t e : sets[s]) matrix.set(s, e);
+    }
+    return matrix;
+};
+
+std::uint64_t CoverageMatrix::fingerprintOf(const network::Network& net, const std::vector<terrain::LatLngAlt>& sites) {
+    // FNV-1a over the parameters of the checks, the elevation grid, and the end device and site positions
+    std::uint64_t hash = 1469598103934665603ull;
+    auto mixBits = [&hash](std::uint64_t bits) {
+        for (int k = 0; k < 8; k++) {
+            hash ^= (bits >> (8 * k)) & 0xff;
+            hash *= 1099511628211ull;
+        }
+    };
+    auto mix = [&mixBits](double value) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        mixBits(bits);
+    };
+    mix(network::MAX_RANGE_SQUARED);
+    mixBits(SAMPLES_STEPS); // Line of sight samples
+    mix(net.getFrame().getOriginLat()); // Range is checked in the local frame
+    mix(net.getFrame().getOriginLng());
+    mixBits(net.getElevationGrid().getChecksum());
+    for (const auto& ed : net.getEndDevices()) {
+        mix(ed.location.lat);
+        mix(ed.location.lng);
+        mix(ed.location.alt);
+    }
+    for (const auto& site : sites) {
+        mix(site.lat);
+        mix(site.lng);
+        mix(site.alt);
+    }
+    return hash;
+};
+
+CoverageMatrix CoverageMatrix::cached(const network::Network& net, const std::vector<terrain::LatLngAlt>& sites, const std::string& filepath) {
+    if (!filepath.empty() && std::ifstream(filepath).good()) {
+        try {
+            CoverageMatrix matrix = fromFile(filepath);
+            if (matrix.fingerprint == fingerprintOf(net, sites)) {
+                global::dbg << "Coverage matrix loaded from " << filepath << std::endl;
+                return matrix;
+            }
+            global::dbg << "Coverage matrix " << filepath << " does not match the network and elevation grid, rebuilding" << std::endl;
+        } catch (const std::exception& e) {
+            global::dbg << e.what() << ", rebuilding" << std::endl;
+        }
+    }
+
+    CoverageMatrix matrix = build(net, sites);
+    if (!filepath.empty()) 
+        matrix.saveToFile(filepath);
+    return matrix;
+};
+
+namespace {
+    constexpr char MAGIC[4] = {'V', 'D', 'C', 'M'};
+    constexpr std::uint32_t VERSION = 3; // 2: range checked in the local frame of the network, 3: fingerprint of the grid and check parameters
+}
+
+void CoverageMatrix::saveToFile(const std::string& filepath) const {
+    std::ofstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open file for writing: " + filepath);
+    }
+    const std::uint64_t num_sites = sites.size(), num_devices = devices;
+    file.write(MAGIC, sizeof(MAGIC));
+    file.write(reinterpret_cast<const char*>(&VERSION), sizeof(VERSION));
+    file.write(reinterpret_cast<const char*>(&num_sites), sizeof(num_sites));
+    file.write(reinterpret_cast<const char*>(&num_devices), sizeof(num_devices));
+    file.write(reinterpret_cast<const char*>(&fingerprint), sizeof(fingerprint));
+    for (const auto& site : sites) {
+        const double values[3] = {site.lat, site.lng, site.alt};
+        file.write(reinterpret_cast<const char*>(values), sizeof(values));
+    }
+    file.write(reinterpret_cast<const char*>(rows.data()), rows.size() * sizeof(std::uint64_t));
+};
+
+CoverageMatrix CoverageMatrix::fromFile(const std::string& filepath) {
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open coverage matrix file: " + filepath);
+    }
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t num_sites, num_devices, fingerprint;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    if (!file || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || version != VERSION) {
+        throw std::runtime_error("Invalid coverage matrix file: " + filepath);
+    }
+    file.read(reinterpret_cast<char*>(&num_sites), sizeof(num_sites));
+    file.read(reinterpret_cast<char*>(&num_devices), sizeof(num_devices));
+    file.read(reinterpret_cast<char*>(&fingerprint), sizeof(fingerprint));
+
+    std::vector<terrain::LatLngAlt> sites(num_sites);
+    for (auto& site : sites) {
+        double values[3];
+        file.read(reinterpret_cast<char*>(values), sizeof(values));
+        site = {values[0], values[1], values[2]};
+    }
+    CoverageMatrix matrix(sites, num_devices);
+    matrix.fingerprint = fingerprint;
+    file.read(reinterpret_cast<char*>(matrix.rows.data()), matrix.rows.size() * sizeof(std::uint64_t));
+    if (!file) {
+        throw std::runtime_error("Truncated coverage matrix file: " + filepath);
+    }
+    return matrix;
+};
+
+SiteLinks siteLinks(const network::Network& net, const CoverageMatrix& matrix) {
+    const auto& grid = net.getElevationGrid();
+    const auto& eds = net.getEndDevices();
+    SiteLinks links(matrix.getNumSites());
+
+    #pragma omp parallel for schedule(dynamic) // parallelize over sites
+    for (int s = 0; s < static_cast<int>(matrix.getNumSites()); s++) {
+        const std::uint64_t* row = matrix.row(s);
+        for (std::size_t w = 0; w < matrix.getNumWords(); w++) {
+            for (std::uint64_t word = row[w]; word != 0; word &= word - 1) {
+                const std::size_t e = w * 64 + __builtin_ctzll(word);
+                links[s].push_back({static_cast<std::uint32_t>(e), 
+                                    grid.haversineDistance(matrix.getSites()[s], eds[e].location)});
+            }
+        }
+    }
+    return links;
+};
+
+} // namespace coverage
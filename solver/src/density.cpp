@@ -0,0 +1,124 @@
+#include "../include/density.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace density {
+
+DensityMap::DensityMap(const std::vector<double>& bbox, std::size_t rows, std::size_t cols)
+    : rows(std::max<std::size_t>(1, rows)), cols(std::max<std::size_t>(1, cols)) {
+    min_lat = bbox[1];
+    min_lng = bbox[0];
+    lat_step = (bbox[3] - bbox[1]) / this->rows;
+    lng_step = (bbox[2] - bbox[0]) / this->cols;
+    row_meters = terrain::EARTH_RADIUS * global::toRadians(std::abs(lat_step));
+    col_meters = terrain::EARTH_RADIUS * global::toRadians(std::abs(lng_step)) * std::cos(global::toRadians((bbox[1] + bbox[3]) / 2));
+    counts.assign(this->rows * this->cols, 0.0);
+    table.assign((this->rows + 1) * (this->cols + 1), 0.0);
+};
+
+void DensityMap::clear() {
+    std::fill(counts.begin(), counts.end(), 0.0);
+    std::fill(table.begin(), table.end(), 0.0);
+    total = 0.0;
+};
+
+std::size_t DensityMap::nearestRow(double lat) const {
+    if(lat_step == 0.0) return 0;
+    const double r = std::round((lat - min_lat) / lat_step);
+    return static_cast<std::size_t>(std::clamp(r, 0.0, double(rows - 1)));
+};
+
+std::size_t DensityMap::nearestCol(double lng) const {
+    if(lng_step == 0.0) return 0;
+    const double c = std::round((lng - min_lng) / lng_step);
+    return static_cast<std::size_t>(std::clamp(c, 0.0, double(cols - 1)));
+};
+
+void DensityMap::add(const terrain::LatLngAlt& position, double weight) {
+    counts[nearestRow(position.lat) * cols + nearestCol(position.lng)] += weight;
+};
+
+void DensityMap::build() {
+    const std::size_t stride = cols + 1;
+    for(std::size_t r = 0; r < rows; r++) {
+        double row_sum = 0.0;
+        for(std::size_t c = 0; c < cols; c++) {
+            row_sum += counts[r * cols + c];
+            table[(r + 1) * stride + c + 1] = table[r * stride + c + 1] + row_sum;
+        }
+    }
+    total = at(rows, cols);
+};
+
+terrain::LatLngAlt DensityMap::nodePosition(std::size_t row, std::size_t col, double alt) const {
+    return {min_lat + row * lat_step, min_lng + col * lng_step, alt};
+};
+
+double DensityMap::boxSum(std::size_t row0, std::size_t col0, std::size_t row1, std::size_t col1) const {
+    return at(row1 + 1, col1 + 1) - at(row0, col1 + 1) - at(row1 + 1, col0) + at(row0, col0);
+};
+
+std::vector<std::size_t> DensityMap::discWidths(double radius) const {
+    const std::size_t half_rows = row_meters > 0.0 ? std::min(rows, static_cast<std::size_t>(radius / row_meters)) : rows;
+    std::vector<std::size_t> widths(half_rows + 1);
+    for(std::size_t dr = 0; dr <= half_rows; dr++) {
+        const double dy = dr * row_meters;
+        const double rem = std::max(0.0, radius * radius - dy * dy);
+        widths[dr] = col_meters > 0.0 ? std::min(cols, static_cast<std::size_t>(std::sqrt(rem) / col_meters)) : cols;
+    }
+    return widths;
+};
+
+double DensityMap::discSum(std::size_t row, std::size_t col, const std::vector<std::size_t>& widths) const {
+    const std::size_t half_rows = widths.size() - 1;
+    const std::size_t r0 = row > half_rows ? row - half_rows : 0;
+    const std::size_t r1 = std::min(rows - 1, row + half_rows);
+
+    double sum = 0.0;
+    for(std::size_t r = r0; r <= r1; r++) {
+        const std::size_t half_cols = widths[r > row ? r - row : row - r];
+        const std::size_t c0 = col > half_cols ? col - half_cols : 0;
+        const std::size_t c1 = std::min(cols - 1, col + half_cols);
+        sum += boxSum(r, c0, r, c1);
+    }
+    return sum;
+};
+
+double DensityMap::discSum(std::size_t row, std::size_t col, double radius) const {
+    return discSum(row, col, discWidths(radius));
+};
+
+double DensityMap::discSum(const terrain::LatLngAlt& position, double radius) const {
+    return discSum(nearestRow(position.lat), nearestCol(position.lng), radius);
+};
+
+bool DensityMap::densest(double radius, std::size_t& row, std::size_t& col, double& weight) const {
+    if(total <= 0.0)
+        return false;
+
+    const std::vector<std::size_t> widths = discWidths(radius);
+    std::vector<double> row_best(rows, 0.0);
+    std::vector<std::size_t> row_col(rows, 0);
+    #pragma omp parallel for schedule(dynamic) // parallelize over rows
+    for(std::size_t r = 0; r < rows; r++) {
+        for(std::size_t c = 0; c < cols; c++) {
+            const double w = discSum(r, c, widths);
+            if(w > row_best[r]) {
+                row_best[r] = w;
+                row_col[r] = c;
+            }
+        }
+    }
+
+    weight = 0.0;
+    for(std::size_t r = 0; r < rows; r++) {
+        if(row_best[r] > weight) {
+            weight = row_best[r];
+            row = r;
+            col = row_col[r];
+        }
+    }
+    return weight > 0.0;
+};
+
+} // namespace density
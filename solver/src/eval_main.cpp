@@ -2,17 +2,177 @@
 
 #include <iostream>
 #include <cstring>
+#include <chrono>
+#include <omp.h>
 #include "../include/global.hpp"
 #include "../include/terrain.hpp"
 #include "../include/network.hpp"
 
 
+// Session mode: one edit per line, one JSON line with the changed assignments per edit
+//   add_ed <id> <lat> <lng> [height]
+//   add_gw <id> <lat> <lng> [height]
+//   move <id> <lat> <lng> [height] (current height of the node if omitted)
+//   remove <id>
+void runSession(network::Network& network) {
+    std::string line;
+    while(std::getline(std::cin, line)) {
+        std::stringstream ss(line);
+        std::string cmd, id;
+        if(!(ss >> cmd)) continue;
+        if(cmd == "quit" || cmd == "exit") break;
+
+        nlohmann::json response;
+        try {
+            if(!(ss >> id)) throw std::runtime_error("Missing node id");
+            network::Delta changes;
+            if(cmd == "remove") {
+                changes = network.removeNode(id);
+            } else {
+                terrain::LatLngAlt pos;
+                if(!(ss >> pos.lat >> pos.lng)) throw std::runtime_error("Missing coordinates");
+                if(!(ss >> pos.alt)) { // Added nodes default to 0 m, moved ones keep their height
+                    pos.alt = 0.0;
+                    if(cmd == "move") {
+                        const int e = network.findEndDevice(id), g = network.findGateway(id);
+                        if(e >= 0) pos.alt = network.getEndDeviceLocation(e).alt;
+                        else if(g >= 0) pos.alt = network.getGatewayLocation(g).alt;
+                    }
+                }
+                if(cmd == "add_ed") changes = network.addEndDevice(id, pos);
+                else if(cmd == "add_gw") changes = network.addGateway(id, pos);
+                else if(cmd == "move") changes = network.moveNode(id, pos);
+                else throw std::runtime_error("Unknown command '" + cmd + "'");
+            }
+            response["changes"] = nlohmann::json::array();
+            for(const auto& c : changes) {
+                response["changes"].push_back({
+                    {"end_device", c.end_device_id},
+                    {"assigned_gateway", c.gateway_id.empty() ? nlohmann::json(nullptr) : nlohmann::json(c.gateway_id)},
+                    {"distance", c.distance}
+                });
+            }
+            response["connected_end_devices"] = network.getConnectedEdCount();
+            response["disconnected_end_devices"] = network.getEndDevices().size() - network.getConnectedEdCount();
+            response["total_distance"] = network.getTotalDistance();
+        } catch(const std::exception& e) {
+            response = {{"error", e.what()}};
+        }
+        std::cout << response.dump() << std::endl;
+    }
+}
+
+
+struct ScenarioResult {
+    std::string file;
+    network::Network network;
+    std::string error; // Empty if the scenario was evaluated
+    double elapsed_ms = 0.0;
+};
+
+// Batch mode: evaluate every network of the manifest against the same elevation grid
+void runBatch(const std::string& manifest, std::shared_ptr<const terrain::ElevationGrid> grid, global::PRINT_TYPE format, unsigned int los_cells) {
+    const std::vector<std::string> files = global::readManifest(manifest);
+    std::vector<ScenarioResult> results(files.size());
+
+    // Scenarios are spread across threads, the remaining threads are used inside each connect()
+    int outer, inner;
+    global::splitThreads(static_cast<int>(files.size()), outer, inner);
+
+    #pragma omp parallel for schedule(dynamic) num_threads(outer)
+    for(int k = 0; k < static_cast<int>(files.size()); k++) {
+        omp_set_num_threads(inner);
+        auto start = std::chrono::steady_clock::now();
+        results[k].file = files[k];
+        try {
+            results[k].network = network::Network::fromGeoJSON(files[k]);
+            results[k].network.setElevationGrid(grid);
+            if(los_cells > 0)
+                results[k].network.setLineOfSightMode(network::CELL_LOS, los_cells);
+            results[k].network.connect();
+        } catch(const std::exception& e) {
+            results[k].error = e.what();
+        }
+        results[k].elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    nlohmann::json summary = nlohmann::json::array();
+    for(const auto& r : results) {
+        const auto& eds = r.network.getEndDevices();
+        summary.push_back({
+            {"file", r.file},
+            {"error", r.error.empty() ? nlohmann::json(nullptr) : nlohmann::json(r.error)},
+            {"num_gateways", r.network.getGatewayCount()},
+            {"num_end_devices", eds.size()},
+            {"connected_end_devices", r.network.getConnectedEdCount()},
+            {"disconnected_end_devices", eds.size() - r.network.getConnectedEdCount()},
+            {"total_distance", r.network.getTotalDistance()},
+            {"elapsed_ms", r.elapsed_ms}
+        });
+    }
+
+    switch(format) {
+        case global::PLAIN_TEXT:
+            for(size_t k = 0; k < results.size(); k++) {
+                std::cout << std::endl << "Scenario " << k + 1 << ": " << results[k].file << std::endl;
+                if(results[k].error.empty()) 
+                    results[k].network.print(global::PLAIN_TEXT);
+                else 
+                    std::cout << "Error: " << results[k].error << std::endl;
+            }
+            std::cout << std::endl << "Summary:" << std::endl;
+            std::cout << "file,num_gateways,num_end_devices,connected_end_devices,disconnected_end_devices,total_distance,elapsed_ms,error" << std::endl;
+            for(const auto& row : summary) {
+                std::cout << row["file"].get<std::string>() << ",";
+                if(row["error"].is_null()) {
+                    std::cout << row["num_gateways"] << ","
+                              << row["num_end_devices"] << ","
+                              << row["connected_end_devices"] << ","
+                              << row["disconnected_end_devices"] << ","
+                              << row["total_distance"] << ",";
+                } else {
+                    std::cout << ",,,,,"; // Nothing was evaluated
+                }
+                std::cout << row["elapsed_ms"] << ",";
+                if(!row["error"].is_null()) { // Quoted, the message may contain commas
+                    std::string error = row["error"].get<std::string>();
+                    for(std::size_t p = error.find('"'); p != std::string::npos; p = error.find('"', p + 2))
+                        error.insert(p, 1, '"');
+                    std::cout << '"' << error << '"';
+                }
+                std::cout << std::endl;
+            }
+            break;
+        case global::JSON: {
+            nlohmann::json output;
+            output["scenarios"] = nlohmann::json::array();
+            for(const auto& r : results) {
+                if(r.error.empty())
+                    output["scenarios"].push_back({{"file", r.file}, {"result", r.network.toFeatureCollection().toJSON()}});
+                else
+                    output["scenarios"].push_back({{"file", r.file}, {"error", r.error}});
+            }
+            output["summary"] = summary;
+            std::cout << output.dump(2) << std::endl;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+
 int main(int argc, char **argv) {
 
     std::string em_filename; // Terrain elevation model file (csv)
     std::string nw_filename; // Network file (geojson)
+    std::string batch_filename; // Manifest with one network file per line
 
     global::PRINT_TYPE outputFormat = global::PLAIN_TEXT;
+    bool session = false; // Keep network in memory and apply edits read from stdin
+    bool projection_report = false; // Accuracy of the local frame used for the range checks
+    unsigned int los_cells = 0; // Grid cells per side of the blocks of the approximate line of sight, 0 for the exact check
+    terrain::GRID_LAYOUT grid_layout = terrain::ROW_MAJOR;
 
     for(int i = 0; i < argc; i++) {    
         if(strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0 || argc == 1)
@@ -51,13 +211,45 @@ int main(int argc, char **argv) {
             }
         }
 
+        if(strcmp(argv[i], "-b") == 0 || strcmp(argv[i], "--batch") == 0) {
+            if(i+1 < argc) {
+                const char* file = argv[i+1];
+                batch_filename = std::string(file);
+            }else{
+                global::printHelp(MANUAL, "Error in argument -b (--batch). A manifest filename must be provided");
+            }
+        }
+
+        if(strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "--session") == 0) {
+            session = true;
+        }
+
+        if(strcmp(argv[i], "--grid-tiles") == 0) {
+            grid_layout = terrain::Z_ORDER_TILES;
+        }
+
+        if(strcmp(argv[i], "--projection") == 0) {
+            projection_report = true;
+        }
+
+        if(strcmp(argv[i], "--los-cells") == 0) {
+            if(i+1 < argc) {
+                const int cells = atoi(argv[i+1]);
+                if(cells < 1)
+                    global::printHelp(MANUAL, "Error in argument --los-cells. A positive integer number must be provided");
+                los_cells = static_cast<unsigned int>(cells);
+            }else{
+                global::printHelp(MANUAL, "Error in argument --los-cells. An integer number must be provided");
+            }
+        }
+
         if(strcmp(argv[i], "--dbg") == 0) {
             global::dbg.rdbuf(std::cout.rdbuf()); // Enable debug output to std::cout
         }
     }
 
     /// Load network
-    if(nw_filename.empty()) {
+    if(nw_filename.empty() && batch_filename.empty()) {
         global::printHelp(MANUAL, "Error in argument -g (--nw_file). A filename must be provided.");
     }
     
@@ -66,14 +258,31 @@ int main(int argc, char **argv) {
         global::printHelp(MANUAL, "Error in argument -f (--em_file). A filename must be provided.");
     }
 
+    terrain::ElevationGrid elevation = terrain::ElevationGrid::fromCSV(em_filename);
+    elevation.setLayout(grid_layout);
+    auto grid = std::make_shared<const terrain::ElevationGrid>(std::move(elevation));
+
+    if(!batch_filename.empty()) {
+        runBatch(batch_filename, grid, outputFormat, los_cells);
+        return 0;
+    }
+
     auto network = network::Network::fromGeoJSON(nw_filename);
-    auto grid = terrain::ElevationGrid::fromCSV(em_filename);
     
     network.setElevationGrid(grid);
+    if(los_cells > 0)
+        network.setLineOfSightMode(network::CELL_LOS, los_cells);
     network.connect();
+    if(projection_report)
+        network.setProperty("projection", network.projectionAccuracy().toJSON());
+    if(los_cells > 0)
+        network.setProperty("line_of_sight", network.lineOfSightAgreement().toJSON());
     
     network.print(outputFormat);
 
+    if(session)
+        runSession(network);
+
     return 0;
 }
 
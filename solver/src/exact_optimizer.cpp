@@ -0,0 +1,256 @@
+#include "../include/exact_optimizer.hpp"
+#include <algorithm>
+
+std::size_t ExactOptimizer::lowerBound(const coverage::DeviceSet& covered) const {
+    const std::size_t uncovered = rows.getNumDevices() - covered.count();
+    if(uncovered == 0) 
+        return 0;
+
+    // Every site covers at most max_gain of the remaining devices
+    std::size_t max_gain = 0;
+    for(std::size_t s = 0; s < rows.getNumSites(); s++) 
+        max_gain = std::max(max_gain, rows.gain(s, covered));
+    if(max_gain == 0)
+        return uncovered; // Unreachable, does not happen after reduction
+    const std::size_t bound_gain = (uncovered + max_gain - 1) / max_gain;
+
+    // Devices that share no site need one site each
+    coverage::DeviceSet blocked(rows.getNumSites());
+    std::size_t bound_disjoint = 0;
+    for(std::size_t d : device_order) {
+        if(covered.test(d)) continue;
+        if(coverage::bits::popcountAnd(cols[d].data(), blocked.data(), blocked.numWords()) == 0) {
+            bound_disjoint++;
+            coverage::bits::orInto(blocked.data(), cols[d].data(), blocked.numWords());
+        }
+    }
+
+    return std::max(bound_gain, bound_disjoint);
+};
+
+void ExactOptimizer::search(coverage::DeviceSet covered, std::vector<std::size_t> chosen, unsigned int depth) {
+    if(stopped) return;
+
+    if(++nodes % EXACT_CHECK_INTERVAL == 0 && std::chrono::steady_clock::now() > search_deadline) {
+        stopped = true;
+        return;
+    }
+
+    // Branch on the uncovered device with fewest sites
+    std::size_t branch = rows.getNumDevices();
+    for(std::size_t d : device_order) {
+        if(!covered.test(d)) {
+            branch = d;
+            break;
+        }
+    }
+
+    if(branch == rows.getNumDevices()) { // Everything covered
+        std::lock_guard<std::mutex> lock(best_mutex);
+        if(chosen.size() < best_size) {
+            best_size = chosen.size();
+            best_solution = chosen;
+            global::dbg << "Incumbent improved to " << best_size << " gateways" << std::endl;
+        }
+        return;
+    }
+
+    if(chosen.size() + lowerBound(covered) >= best_size) 
+        return;
+
+    // Sites covering the branching device, most new devices first
+    std::vector<std::pair<std::size_t, std::size_t>> candidates; // (gain, site)
+    for(std::size_t s = 0; s < rows.getNumSites(); s++) {
+        if(cols[branch].test(s)) 
+            candidates.push_back({rows.gain(s, covered), s});
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+
+    for(const auto& candidate : candidates) {
+        coverage::DeviceSet next = covered;
+        rows.addTo(candidate.second, next);
+        std::vector<std::size_t> next_chosen = chosen;
+        next_chosen.push_back(candidate.second);
+        if(depth < EXACT_TASK_DEPTH) {
+            #pragma omp task firstprivate(next, next_chosen, depth)
+            search(std::move(next), std::move(next_chosen), depth + 1);
+        } else {
+            search(std::move(next), std::move(next_chosen), depth + 1);
+        }
+    }
+};
+
+void ExactOptimizer::optimize(double timeLimit) {
+    startTelemetry();
+    stop_reason = optimizer::NOT_STOPPED;
+    search_deadline = std::min(deadline, std::chrono::steady_clock::now() + 
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(timeLimit)));
+
+    const coverage::CoverageMatrix matrix = coverage::CoverageMatrix::cached(
+        network, coverage::candidateSites(network, spacing, height), coverage_file);
+    const std::size_t num_sites = matrix.getNumSites();
+    const std::size_t num_eds = matrix.getNumDevices();
+
+    // Devices to cover: reachable from some site and not served by the current gateways
+    network.connect();
+    coverage::DeviceSet target(num_eds);
+    for(std::size_t s = 0; s < num_sites; s++) 
+        matrix.addTo(s, target);
+    for(std::size_t e = 0; e < num_eds; e++) {
+        if(network.getEndDevices()[e].assigned_gateway != nullptr) 
+            target.reset(e);
+    }
+    std::vector<std::size_t> devices;
+    for(std::size_t e = 0; e < num_eds; e++) {
+        if(target.test(e)) devices.push_back(e);
+    }
+
+    // Sites covering each device
+    std::vector<coverage::DeviceSet> device_sites(devices.size(), coverage::DeviceSet(num_sites));
+    #pragma omp parallel for schedule(static)
+    for(int k = 0; k < static_cast<int>(devices.size()); k++) {
+        for(std::size_t s = 0; s < num_sites; s++) {
+            if(matrix.covers(s, devices[k])) device_sites[k].set(s);
+        }
+    }
+
+    // Device reduction: if the sites of i are a subset of the sites of j, covering i covers j
+    const std::size_t site_words = coverage::paddedWords(num_sites);
+    std::vector<char> keep_device(devices.size(), 1);
+    #pragma omp parallel for schedule(dynamic)
+    for(int j = 0; j < static_cast<int>(devices.size()); j++) {
+        for(int i = 0; i < static_cast<int>(devices.size()) && keep_device[j]; i++) {
+            if(i == j) continue;
+            const bool subset = coverage::bits::popcountAndNot(device_sites[i].data(), device_sites[j].data(), site_words) == 0;
+            const bool equal = subset && coverage::bits::popcountAndNot(device_sites[j].data(), device_sites[i].data(), site_words) == 0;
+            if(subset && (!equal || i < j)) keep_device[j] = 0; // Equal sets keep the first device
+        }
+    }
+    std::vector<std::size_t> kept_devices;
+    for(std::size_t k = 0; k < devices.size(); k++) {
+        if(keep_device[k]) kept_devices.push_back(devices[k]);
+    }
+
+    // Site reduction over the kept devices: drop sites whose devices are a subset of another site
+    coverage::CoverageMatrix reduced(matrix.getSites(), kept_devices.size());
+    #pragma omp parallel for schedule(static)
+    for(int s = 0; s < static_cast<int>(num_sites); s++) {
+        for(std::size_t k = 0; k < kept_devices.size(); k++) {
+            if(matrix.covers(s, kept_devices[k])) reduced.set(s, k);
+        }
+    }
+    std::vector<char> keep_site(num_sites, 1);
+    #pragma omp parallel for schedule(dynamic)
+    for(int s = 0; s < static_cast<int>(num_sites); s++) {
+        const std::size_t size = reduced.count(s);
+        if(size == 0) {
+            keep_site[s] = 0;
+            continue;
+        }
+        for(int t = 0; t < static_cast<int>(num_sites) && keep_site[s]; t++) {
+            if(t == s || coverage::bits::popcountAndNot(reduced.row(s), reduced.row(t), reduced.getNumWords()) != 0) continue;
+            if(reduced.count(t) > size || t < s) keep_site[s] = 0; // Equal rows keep the first site
+        }
+    }
+    std::vector<terrain::LatLngAlt> kept_sites;
+    std::vector<std::size_t> kept_site_index;
+    for(std::size_t s = 0; s < num_sites; s++) {
+        if(keep_site[s]) {
+            kept_sites.push_back(matrix.getSites()[s]);
+            kept_site_index.push_back(s);
+        }
+    }
+
+    rows = coverage::CoverageMatrix(kept_sites, kept_devices.size());
+    cols.assign(kept_devices.size(), coverage::DeviceSet(kept_sites.size()));
+    col_count.assign(kept_devices.size(), 0);
+    for(std::size_t s = 0; s < kept_sites.size(); s++) {
+        for(std::size_t k = 0; k < kept_devices.size(); k++) {
+            if(reduced.covers(kept_site_index[s], k)) {
+                rows.set(s, k);
+                cols[k].set(s);
+                col_count[k]++;
+            }
+        }
+    }
+    device_order.resize(kept_devices.size());
+    for(std::size_t k = 0; k < device_order.size(); k++) device_order[k] = k;
+    std::stable_sort(device_order.begin(), device_order.end(), [&](std::size_t a, std::size_t b) {
+        return col_count[a] < col_count[b];
+    });
+
+    global::dbg << "Reduced problem: " << kept_sites.size() << "/" << num_sites << " sites, " 
+                << kept_devices.size() << "/" << devices.size() << " devices" << std::endl;
+
+    // Sites that are the only option of some device
+    coverage::DeviceSet covered(kept_devices.size());
+    std::vector<std::size_t> chosen;
+    for(std::size_t k = 0; k < kept_devices.size(); k++) {
+        if(col_count[k] != 1) continue;
+        for(std::size_t s = 0; s < kept_sites.size(); s++) {
+            if(cols[k].test(s) && std::find(chosen.begin(), chosen.end(), s) == chosen.end()) {
+                chosen.push_back(s);
+                rows.addTo(s, covered);
+            }
+        }
+    }
+
+    // Initial incumbent: greedy completion
+    best_solution = chosen;
+    coverage::DeviceSet greedy_covered = covered;
+    while(greedy_covered.count() < kept_devices.size()) {
+        std::size_t best_site = 0, best_gain = 0;
+        for(std::size_t s = 0; s < kept_sites.size(); s++) {
+            const std::size_t gain = rows.gain(s, greedy_covered);
+            if(gain > best_gain) {
+                best_gain = gain;
+                best_site = s;
+            }
+        }
+        best_solution.push_back(best_site);
+        rows.addTo(best_site, greedy_covered);
+    }
+    best_size = best_solution.size();
+    nodes = 0;
+    stopped = false;
+
+    lower_bound = chosen.size() + lowerBound(covered);
+    global::dbg << "Greedy incumbent: " << best_size << " gateways, root lower bound: " << lower_bound << std::endl;
+
+    if(lower_bound < best_size) {
+        #pragma omp parallel
+        #pragma omp single
+        search(covered, chosen, 0);
+    }
+
+    optimal = !stopped;
+    if(optimal) 
+        lower_bound = best_size;
+    stop_reason = optimal ? optimizer::CONVERGED : optimizer::TIME_LIMIT;
+    evaluations = nodes;
+
+    for(std::size_t s : best_solution) 
+        network.addGateway(kept_sites[s]);
+    network.connect();
+    record(nodes, optimizer::Score::of(network));
+
+    const double elapsed = getElapsed();
+    network.setProperty("optimization", {
+        {"algorithm", "exact"},
+        {"optimal", optimal},
+        {"gateways_added", best_size.load()},
+        {"lower_bound", lower_bound},
+        {"gap", getGap()},
+        {"nodes", nodes.load()},
+        {"candidate_sites", num_sites},
+        {"reduced_sites", kept_sites.size()},
+        {"reduced_end_devices", kept_devices.size()},
+        {"stop_reason", optimizer::stopReasonName(stop_reason)},
+        {"elapsed_ms", elapsed}
+    });
+
+    global::dbg << (optimal ? "Optimal" : "Time limit reached") << ": " << best_size << " gateways, gap " 
+                << getGap() * 100.0 << "%, " << nodes << " nodes" << std::endl;
+};
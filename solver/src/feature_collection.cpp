@@ -1,8 +1,35 @@
 #include "../include/feature_collection.hpp"
+#include <limits>
 
 
 namespace geojson {
 
+namespace {
+
+// Linear rings of at least 4 positions of [lon, lat]
+Polygon parsePolygon(const json& coords) {
+    if(!coords.is_array() || coords.empty()) {
+        throw std::runtime_error("Invalid GeoJSON: invalid Polygon coordinates.");
+    }
+    Polygon polygon;
+    for(const auto& ring : coords) {
+        if(!ring.is_array() || ring.size() < 4) {
+            throw std::runtime_error("Invalid GeoJSON: polygon rings must have at least 4 positions.");
+        }
+        LineString positions;
+        for(const auto& pos : ring) {
+            if(!pos.is_array() || pos.size() < 2 || !pos[0].is_number() || !pos[1].is_number()) {
+                throw std::runtime_error("Invalid GeoJSON: invalid polygon position.");
+            }
+            positions.push_back(Position{pos[0].get<double>(), pos[1].get<double>()});
+        }
+        polygon.push_back(positions);
+    }
+    return polygon;
+}
+
+} // namespace
+
 FeatureCollection FeatureCollection::fromGeoJSON(const std::string& filename) {
     FeatureCollection fc;
 
@@ -26,24 +53,41 @@ FeatureCollection FeatureCollection::fromGeoJSON(const std::string& filename) {
         const auto& properties = feature.at("properties");
         const auto& geometry   = feature.at("geometry");
 
-        if(geometry.value("type", "") != "Point") { // TODO: add support for other geometry types
-            throw std::runtime_error("Invalid GeoJSON: only 'Point' geometries are supported.");
-        }
+        const std::string geometry_type = geometry.value("type", "");
+        const auto& coords = geometry.at("coordinates");
+        std::string type = detail::require_string(properties, "type");
 
-        auto coords = geometry.at("coordinates");
-        if(!coords.is_array() || coords.size() < 2) {
-            throw std::runtime_error("Invalid GeoJSON: invalid coordinates.");
-        }
+        if(geometry_type == "Point") {
+            if(!coords.is_array() || coords.size() < 2) {
+                throw std::runtime_error("Invalid GeoJSON: invalid coordinates.");
+            }
 
-        double lng = coords[0];
-        double lat = coords[1];
-        
-        std::string type = detail::require_string(properties, "type");
+            double lng = coords[0];
+            double lat = coords[1];
 
-        if(type == "gateway" || type == "end_device") {
-            fc.addFeature(Feature(POINT, Position{lng, lat}, properties));
+            if(type == "gateway" || type == "end_device") {
+                fc.addFeature(Feature(POINT, Position{lng, lat}, properties));
+            } else {
+                throw std::runtime_error("Invalid GeoJSON: unknown feature type '" + type + "'");
+            }
+        } else if(geometry_type == "Polygon" || geometry_type == "MultiPolygon") { // Zones for gateway placement
+            if(type != "allowed_zone" && type != "forbidden_zone") {
+                throw std::runtime_error("Invalid GeoJSON: polygon features must be of type 'allowed_zone' or 'forbidden_zone'");
+            }
+            if(geometry_type == "Polygon") {
+                Polygon polygon = parsePolygon(coords);
+                fc.addFeature(Feature(POLYGON, polygon, properties));
+            } else {
+                if(!coords.is_array()) {
+                    throw std::runtime_error("Invalid GeoJSON: invalid MultiPolygon coordinates.");
+                }
+                MultiPolygon multi;
+                for(const auto& polygon : coords)
+                    multi.push_back(parsePolygon(polygon));
+                fc.addFeature(Feature(MULTIPOLYGON, multi, properties));
+            }
         } else {
-            throw std::runtime_error("Invalid GeoJSON: unknown feature type '" + type + "'");
+            throw std::runtime_error("Invalid GeoJSON: only 'Point', 'Polygon' and 'MultiPolygon' geometries are supported.");
         }
     }
 
@@ -51,26 +95,26 @@ FeatureCollection FeatureCollection::fromGeoJSON(const std::string& filename) {
     if(data.contains("bbox") && data["bbox"].is_array() && data["bbox"].size() == 4) {
         fc.bbox = data["bbox"].get<std::vector<double>>();
     } else {
-        if(!fc.features.empty()) {
-            double minLng = std::get<Position>(fc.features[0].coords)[0]; // lng
-            double minLat = std::get<Position>(fc.features[0].coords)[1]; // lat
-            double maxLng = minLng;
-            double maxLat = minLat;
-            for(const auto& feat : fc.features) {
-                const auto& pos = std::get<Position>(feat.coords);
-                if(pos[0] < minLng) minLng = pos[0];
-                if(pos[1] < minLat) minLat = pos[1];
-                if(pos[0] > maxLng) maxLng = pos[0];
-                if(pos[1] > maxLat) maxLat = pos[1];
-            }
-            fc.bbox = {minLng, minLat, maxLng, maxLat};
+        double minLng = std::numeric_limits<double>::max();
+        double minLat = std::numeric_limits<double>::max();
+        double maxLng = std::numeric_limits<double>::lowest();
+        double maxLat = std::numeric_limits<double>::lowest();
+        for(const auto& feat : fc.features) { // Nodes only, zones do not extend the network area
+            if(feat.geometry_type != POINT) continue;
+            const auto& pos = std::get<Position>(feat.coords);
+            if(pos[0] < minLng) minLng = pos[0];
+            if(pos[1] < minLat) minLat = pos[1];
+            if(pos[0] > maxLng) maxLng = pos[0];
+            if(pos[1] > maxLat) maxLat = pos[1];
         }
+        if(minLng <= maxLng)
+            fc.bbox = {minLng, minLat, maxLng, maxLat};
     }
 
     return fc;
 }
 
-void FeatureCollection::saveToFile(const std::string& filename) const {
+json FeatureCollection::toJSON() const {
     json data;
     data["type"] = "FeatureCollection";
     data["features"] = json::array();
@@ -109,12 +153,23 @@ void FeatureCollection::saveToFile(const std::string& filename) const {
         data["features"].push_back(feat);
     }
 
+    if(!properties.is_null()) {
+        data["properties"] = properties;
+    }
+    if(!bbox.empty()) {
+        data["bbox"] = bbox;
+    }
+
+    return data;
+};
+
+void FeatureCollection::saveToFile(const std::string& filename) const {
     std::ofstream file(filename);
     if (!file.is_open()) {
         throw std::runtime_error("Could not open file for writing: " + filename);
     }
 
-    file << data.dump(4); // Pretty print with 4 spaces
+    file << toJSON().dump(4); // Pretty print with 4 spaces
 };
 
 void FeatureCollection::print() const {
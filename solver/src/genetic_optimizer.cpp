@@ -0,0 +1,262 @@
+#include "../include/genetic_optimizer.hpp"
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <omp.h>
+
+std::size_t GeneticOptimizer::GenomeHash::operator()(const Genome& genome) const {
+    std::uint64_t hash = 14695981039346656037ull; // FNV-1a
+    for(std::uint32_t s : genome) {
+        hash ^= s;
+        hash *= 1099511628211ull;
+    }
+    return static_cast<std::size_t>(hash);
+};
+
+GeneticOptimizer::Fitness GeneticOptimizer::evaluate(const Genome& genome, std::vector<double>& dist) const {
+    std::copy(fixed_dist.begin(), fixed_dist.end(), dist.begin());
+    for(std::uint32_t s : genome) {
+        for(const auto& link : site_devices[s])
+            dist[link.device] = std::min(dist[link.device], double(link.distance));
+    }
+
+    Fitness fitness;
+    fitness.cost = genome.size();
+    for(double d : dist) {
+        fitness.cost += optimizer::deviceCost(d);
+        if(!std::isinf(d)) {
+            fitness.connected++;
+            fitness.distance += d;
+        }
+    }
+    return fitness;
+};
+
+void GeneticOptimizer::evaluateAll(const std::vector<Genome>& population, std::vector<Fitness>& fitness) {
+    fitness.resize(population.size());
+
+    // Genomes not seen before, each one once
+    std::vector<std::size_t> pending;
+    std::unordered_map<Genome, std::size_t, GenomeHash> first;
+    std::vector<std::size_t> source(population.size());
+    for(std::size_t i = 0; i < population.size(); i++) {
+        auto cached = cache.find(population[i]);
+        if(cached != cache.end()) {
+            fitness[i] = cached->second;
+            source[i] = i;
+            cache_hits++;
+            continue;
+        }
+        auto seen = first.emplace(population[i], i);
+        source[i] = seen.first->second;
+        if(seen.second)
+            pending.push_back(i);
+        else
+            cache_hits++;
+    }
+
+    #pragma omp parallel for schedule(dynamic) // parallelize over individuals
+    for(std::size_t p = 0; p < pending.size(); p++) {
+        const std::size_t i = pending[p];
+        fitness[i] = evaluate(population[i], buffers[omp_get_thread_num()]);
+    }
+
+    evaluations += pending.size();
+    for(std::size_t i : pending)
+        cache.emplace(population[i], fitness[i]);
+    for(std::size_t i = 0; i < population.size(); i++)
+        fitness[i] = fitness[source[i]];
+};
+
+// Random cover: unconnected devices in random order get a random site in range if still uncovered
+GeneticOptimizer::Genome GeneticOptimizer::randomGenome() {
+    std::vector<std::uint32_t> order;
+    for(std::size_t e = 0; e < device_sites.size(); e++) {
+        if(std::isinf(fixed_dist[e]) && !device_sites[e].empty())
+            order.push_back(e);
+    }
+    std::shuffle(order.begin(), order.end(), gen);
+
+    Genome genome;
+    coverage::DeviceSet covered(device_sites.size());
+    for(std::uint32_t e : order) {
+        if(covered.test(e)) continue;
+        std::uniform_int_distribution<std::size_t> site(0, device_sites[e].size() - 1);
+        const std::uint32_t s = device_sites[e][site(gen)];
+        genome.push_back(s);
+        matrix.addTo(s, covered);
+    }
+    std::sort(genome.begin(), genome.end());
+    return genome;
+};
+
+// Sites of the first parent on one side of a random line and sites of the second one on the other side
+GeneticOptimizer::Genome GeneticOptimizer::crossover(const Genome& a, const Genome& b) {
+    const auto& sites = matrix.getSites();
+    std::uniform_int_distribution<std::size_t> any_site(0, sites.size() - 1);
+    std::uniform_real_distribution<double> angle(0.0, 2.0 * M_PI);
+
+    const terrain::LatLngAlt pivot = sites[any_site(gen)];
+    const double theta = angle(gen);
+    const double cos_lat = std::cos(pivot.lat * M_PI / 180.0);
+    auto side = [&](std::uint32_t s) {
+        return (sites[s].lat - pivot.lat) * std::cos(theta) + (sites[s].lng - pivot.lng) * cos_lat * std::sin(theta) >= 0.0;
+    };
+
+    Genome child;
+    for(std::uint32_t s : a)
+        if(side(s)) child.push_back(s);
+    for(std::uint32_t s : b)
+        if(!side(s)) child.push_back(s);
+    std::sort(child.begin(), child.end());
+    return child;
+};
+
+void GeneticOptimizer::mutate(Genome& genome) {
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    if(!genome.empty() && uniform(gen) < GENETIC_MUTATION_RATE) { // Remove a site
+        std::uniform_int_distribution<std::size_t> pick(0, genome.size() - 1);
+        genome.erase(genome.begin() + pick(gen));
+    }
+
+    if(!genome.empty() && uniform(gen) < GENETIC_MUTATION_RATE) { // Move a site to another one reaching a device of it
+        std::uniform_int_distribution<std::size_t> pick(0, genome.size() - 1);
+        std::uint32_t& s = genome[pick(gen)];
+        if(!site_devices[s].empty()) {
+            std::uniform_int_distribution<std::size_t> device(0, site_devices[s].size() - 1);
+            const auto& near = device_sites[site_devices[s][device(gen)].device];
+            std::uniform_int_distribution<std::size_t> site(0, near.size() - 1);
+            s = near[site(gen)];
+        }
+    }
+
+    if(uniform(gen) < GENETIC_MUTATION_RATE) { // Add a site reaching a device that no site of the genome reaches
+        std::uniform_int_distribution<std::size_t> device(0, device_sites.size() - 1);
+        for(int attempt = 0; attempt < 8; attempt++) {
+            const std::size_t e = device(gen);
+            if(!std::isinf(fixed_dist[e]) || device_sites[e].empty()) continue;
+            const bool reached = std::any_of(genome.begin(), genome.end(), [&](std::uint32_t s) { return matrix.covers(s, e); });
+            if(reached) continue;
+            std::uniform_int_distribution<std::size_t> site(0, device_sites[e].size() - 1);
+            genome.push_back(device_sites[e][site(gen)]);
+            break;
+        }
+    }
+
+    std::sort(genome.begin(), genome.end());
+    genome.erase(std::unique(genome.begin(), genome.end()), genome.end());
+};
+
+void GeneticOptimizer::optimize(unsigned int generations) {
+
+    startTelemetry();
+    stop_reason = optimizer::NOT_STOPPED;
+    cache.clear();
+    cache_hits = 0;
+
+    matrix = coverage::CoverageMatrix::cached(
+        network, coverage::candidateSites(network, spacing, height), coverage_file);
+    const std::size_t num_sites = matrix.getNumSites();
+    const std::size_t num_devices = network.getEndDevices().size();
+
+    global::dbg << "Candidate sites: " << num_sites << std::endl;
+
+    if(num_sites == 0 || num_devices == 0) {
+        network.connect();
+        return;
+    }
+
+    site_devices = coverage::siteLinks(network, matrix);
+    device_sites.assign(num_devices, {});
+    for(std::size_t s = 0; s < num_sites; s++) {
+        for(const auto& link : site_devices[s])
+            device_sites[link.device].push_back(s);
+    }
+
+    fixed_dist = optimizer::fixedDistances(network);
+    const std::size_t fixed_gateways = network.getGatewayCount();
+
+    buffers.assign(omp_get_max_threads(), std::vector<double>(num_devices));
+
+    std::vector<Genome> population(GENETIC_POPULATION);
+    for(auto& genome : population)
+        genome = randomGenome();
+    std::vector<Fitness> fitness;
+    evaluateAll(population, fitness);
+
+    std::vector<std::size_t> ranking(population.size());
+    auto rank = [&]() {
+        std::iota(ranking.begin(), ranking.end(), 0);
+        std::stable_sort(ranking.begin(), ranking.end(), [&](std::size_t i, std::size_t j) {
+            return fitness[i].cost < fitness[j].cost;
+        });
+    };
+
+    std::uniform_int_distribution<std::size_t> any_individual(0, population.size() - 1);
+    auto tournament = [&]() {
+        std::size_t winner = any_individual(gen);
+        for(int t = 1; t < GENETIC_TOURNAMENT; t++) {
+            const std::size_t rival = any_individual(gen);
+            if(fitness[rival].cost < fitness[winner].cost)
+                winner = rival;
+        }
+        return winner;
+    };
+
+    unsigned int g = 0;
+    for(; g < generations; g++) {
+        if(deadlineReached()) {
+            global::dbg << "Time limit reached at generation " << g << std::endl;
+            stop_reason = optimizer::TIME_LIMIT;
+            break;
+        }
+
+        rank();
+        const Fitness& best = fitness[ranking[0]];
+        record(g, {best.connected, fixed_gateways + population[ranking[0]].size(), best.distance});
+
+        global::dbg << "Generation " << g + 1 << "/" << generations << ": best cost " << best.cost
+                    << " (" << population[ranking[0]].size() << " gateways)" << std::endl;
+
+        std::vector<Genome> next;
+        next.reserve(population.size());
+        for(std::size_t i = 0; i < GENETIC_ELITE && i < population.size(); i++)
+            next.push_back(population[ranking[i]]);
+        while(next.size() < population.size()) {
+            const std::size_t a = tournament();
+            const std::size_t b = tournament();
+            Genome child = crossover(population[a], population[b]);
+            mutate(child);
+            next.push_back(std::move(child));
+        }
+
+        population = std::move(next);
+        evaluateAll(population, fitness);
+    }
+
+    if(stop_reason == optimizer::NOT_STOPPED)
+        stop_reason = optimizer::ITERATION_LIMIT;
+
+    rank();
+    const Genome& best = population[ranking[0]];
+    for(std::uint32_t s : best)
+        network.addGateway(matrix.getSites()[s]);
+    network.connect();
+    record(g, optimizer::Score::of(network));
+
+    global::dbg << "Evaluations: " << evaluations << ", cache hits: " << cache_hits << std::endl;
+
+    network.setProperty("optimization", {
+        {"algorithm", "genetic"},
+        {"generations", g},
+        {"population", population.size()},
+        {"evaluations", evaluations},
+        {"cache_hits", cache_hits},
+        {"gateways_added", best.size()},
+        {"cost", fitness[ranking[0]].cost},
+        {"candidate_sites", num_sites},
+        {"stop_reason", optimizer::stopReasonName(stop_reason)},
+        {"elapsed_ms", getElapsed()}
+    });
+};
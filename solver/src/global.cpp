@@ -1,4 +1,6 @@
 #include "../include/global.hpp"
+#include <algorithm>
+#include <omp.h>
 
 namespace global {
 
@@ -17,11 +19,9 @@ std::string getExecutableDir() {
 #endif
 }
 
-std::string generate_uuid() {
-    static std::random_device              rd;
-    static std::mt19937                    gen(rd());
-    static std::uniform_int_distribution<> dis(0, 15);
-    static std::uniform_int_distribution<> dis2(8, 11);
+std::string generate_uuid(rng::Philox& gen) {
+    std::uniform_int_distribution<> dis(0, 15);
+    std::uniform_int_distribution<> dis2(8, 11);
 
     std::stringstream ss;
     int i;
@@ -50,6 +50,32 @@ std::string generate_uuid() {
 }
 
 
+void splitThreads(int tasks, int& outer, int& inner) {
+    const int threads = omp_get_max_threads();
+    outer = std::max(1, std::min(threads, tasks));
+    inner = std::max(1, threads / outer);
+    omp_set_max_active_levels(2); // Allow the inner loops to run in parallel too
+}
+
+std::vector<std::string> readManifest(const std::string& filepath) {
+    std::ifstream file(filepath);
+    if(!file.is_open()) {
+        throw std::runtime_error("Could not open manifest file: " + filepath);
+    }
+    const size_t slash = filepath.find_last_of('/');
+    const std::string dir = slash == std::string::npos ? "" : filepath.substr(0, slash + 1);
+
+    std::vector<std::string> files;
+    std::string line;
+    while(std::getline(file, line)) {
+        line.erase(0, line.find_first_not_of(" \t\r"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if(line.empty() || line[0] == '#') continue;
+        files.push_back(line[0] == '/' ? line : dir + line);
+    }
+    return files;
+}
+
 void printHelp(const char* file, const char* message) { // Open readme file with manual and print on terminal   
     std::cerr << std::endl << message << std::endl << std::endl;
     std::ifstream manualFile(file);
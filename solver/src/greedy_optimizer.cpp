@@ -0,0 +1,89 @@
+#include "../include/greedy_optimizer.hpp"
+#include <queue>
+
+void GreedyOptimizer::optimize(unsigned int maxGateways) {
+
+    startTelemetry();
+    stop_reason = optimizer::NOT_STOPPED;
+
+    const coverage::CoverageMatrix matrix = coverage::CoverageMatrix::cached(
+        network, coverage::candidateSites(network, spacing, height), coverage_file);
+    const auto& sites = matrix.getSites();
+
+    global::dbg << "Candidate sites: " << sites.size() 
+                << (coverage::bits::hasAVX2() ? " (AVX2 kernels)" : " (scalar kernels)") << std::endl;
+
+    // Devices already served by the gateways of the network do not count as gain
+    network.connect();
+    coverage::DeviceSet covered(network.getEndDevices().size());
+    for(std::size_t e = 0; e < covered.size(); e++) {
+        if(network.getEndDevices()[e].assigned_gateway != nullptr) 
+            covered.set(e);
+    }
+
+    struct Entry {
+        std::size_t gain;
+        std::size_t site;
+        unsigned int round; // Selection round in which the gain was computed
+        bool operator<(const Entry& other) const { // Max gain first, lowest site index on ties
+            return gain != other.gain ? gain < other.gain : site > other.site;
+        }
+    };
+
+    std::priority_queue<Entry> queue;
+    for(std::size_t s = 0; s < sites.size(); s++) {
+        const std::size_t gain = matrix.gain(s, covered);
+        if(gain > 0) queue.push({gain, s, 0});
+    }
+
+    unsigned int round = 0;
+    evaluations = sites.size();
+    while(!queue.empty()) {
+        if(round >= maxGateways) {
+            stop_reason = optimizer::ITERATION_LIMIT;
+            break;
+        }
+        if(deadlineReached()) {
+            global::dbg << "Time limit reached after " << round << " gateways" << std::endl;
+            stop_reason = optimizer::TIME_LIMIT;
+            break;
+        }
+
+        Entry top = queue.top();
+        queue.pop();
+        if(top.gain == 0) break;
+
+        if(top.round != round) { // Stale upper bound, reevaluate and put back
+            top.gain = matrix.gain(top.site, covered);
+            top.round = round;
+            queue.push(top);
+            evaluations++;
+            continue;
+        }
+
+        matrix.addTo(top.site, covered);
+        network.addGateway(sites[top.site]);
+        round++;
+
+        global::dbg << "Gateway #" << round << " at site " << top.site 
+                    << " (lat: " << sites[top.site].lat << ", lng: " << sites[top.site].lng 
+                    << ") covers " << top.gain << " new devices" << std::endl;
+    }
+
+    global::dbg << "Gain evaluations: " << evaluations << std::endl;
+
+    if(stop_reason == optimizer::NOT_STOPPED) // Nothing left to cover
+        stop_reason = optimizer::CONVERGED;
+
+    network.connect();
+    record(round, optimizer::Score::of(network));
+
+    network.setProperty("optimization", {
+        {"algorithm", "greedy"},
+        {"gateways_added", round},
+        {"evaluations", evaluations},
+        {"candidate_sites", sites.size()},
+        {"stop_reason", optimizer::stopReasonName(stop_reason)},
+        {"elapsed_ms", getElapsed()}
+    });
+};
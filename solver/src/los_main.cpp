@@ -1,10 +1,25 @@
 #define MANUAL "assets/los_manual.txt"
 
 #include <iostream>
+#include <sstream>
 #include <cstring>
 #include "../include/global.hpp"
 #include "../include/terrain.hpp"
 
+// Comma separated list of non-negative numbers, empty if invalid
+std::vector<double> parseHeights(const char* arg) {
+    std::vector<double> heights;
+    std::stringstream ss(arg);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        char* end = nullptr;
+        const double h = strtod(item.c_str(), &end);
+        if (item.empty() || *end != '\0' || h < 0.0) return {};
+        heights.push_back(h);
+    }
+    return heights;
+}
+
 int main(int argc, char **argv) {
 
     std::string filename;
@@ -13,6 +28,7 @@ int main(int argc, char **argv) {
 
     double lat1 = 0.0, lon1 = 0.0, h1 = 2.0;
     double lat2 = 0.0, lon2 = 0.0, h2 = 2.0;
+    std::vector<double> heights1, heights2; // Antenna heights to sweep, the heights of -p1 and -p2 if empty
 
     for(int i = 0; i < argc; i++) {    
         if(strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0 || argc == 1)
@@ -55,6 +71,14 @@ int main(int argc, char **argv) {
             }
         }
 
+        if(strcmp(argv[i], "--heights1") == 0 || strcmp(argv[i], "--heights2") == 0) {
+            std::vector<double>& heights = strcmp(argv[i], "--heights1") == 0 ? heights1 : heights2;
+            if(i+1 < argc)
+                heights = parseHeights(argv[i+1]);
+            if(heights.empty())
+                global::printHelp(MANUAL, (std::string("Error in argument ") + argv[i] + ". A comma separated list of non-negative heights must be provided").c_str());
+        }
+
         if(strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--output") == 0) {
             if(i+1 < argc) {
                 const char* fmt = argv[i+1];
@@ -101,15 +125,33 @@ int main(int argc, char **argv) {
         return 1;
     }
 
-    const bool los = grid.lineOfSight(lat1, lon1, lat2, lon2, h1, h2);
-    const bool losFresnel = grid.lineOfSight(lat1, lon1, lat2, lon2, h1, h2, true);
+    if (heights1.empty()) heights1 = {h1};
+    if (heights2.empty()) heights2 = {h2};
 
     const double totalDistance = grid.haversineDistance(lat1, lon1, lat2, lon2);
 
+    // Single terrain walk, every height pair is evaluated without clearance and with the Fresnel zone of each band
     std::vector<double> profile;
     std::vector<double> distances;
     grid.terrainProfile(lat1, lon1, lat2, lon2, profile, distances);
 
+    const std::vector<double> wavelengths = {0.0, US915_LORA_LAMBDA, EU860_LORA_LAMBDA};
+    std::vector<terrain::LinkScenario> scenarios;
+    for (double a : heights1) {
+        for (double b : heights2) {
+            for (double lambda : wavelengths)
+                scenarios.push_back({a, b, lambda, FRESNEL_CLEARANCE_FACTOR});
+        }
+    }
+    const std::vector<terrain::LinkResult> results = terrain::ElevationGrid::lineOfSight(
+        profile, grid.equirectangularDistance(lat1, lon1, lat2, lon2), scenarios);
+
+    // First height pair
+    h1 = heights1.front();
+    h2 = heights2.front();
+    const bool los = results[0].clear;
+    const bool losFresnel = results[1].clear;
+
     switch(outputFormat) {
         case global::PLAIN_TEXT:
             std::cout << "Line of sight from (" 
@@ -122,6 +164,15 @@ int main(int argc, char **argv) {
                 if (losFresnel) std::cout << "CLEAR\n"; else std::cout << "BLOCKED\n";
                 std::cout << "  assuming 60% Fresnel zone clearance)\n";
             }
+            if (scenarios.size() > wavelengths.size()) {
+                std::cout << "Height sweep (clearance margin in meters, 60% Fresnel zone clearance for 915 and 868 MHz):\n";
+                for (size_t s = 0; s < scenarios.size(); s += wavelengths.size()) {
+                    std::cout << "  " << scenarios[s].observerHeight << "m / " << scenarios[s].targetHeight << "m:";
+                    for (size_t w = 0; w < wavelengths.size(); ++w)
+                        std::cout << " " << (results[s + w].clear ? "CLEAR" : "BLOCKED") << " (" << results[s + w].margin << ")";
+                    std::cout << "\n";
+                }
+            }
             break;
         case global::JSON:
             std::cout << "{\n"
@@ -130,6 +181,18 @@ int main(int argc, char **argv) {
                 << "  \"distance_m\": " << totalDistance << ",\n"
                 << "  \"line_of_sight\": " << (los ? "true" : "false") << ",\n"
                 << "  \"line_of_sight_fresnel_60pct\": " << (losFresnel ? "true" : "false") << ",\n";
+
+                std::cout << "  \"scenarios\": [\n";
+                for (size_t s = 0; s < scenarios.size(); s += wavelengths.size()) {
+                    std::cout << "    {\"height1_m\": " << scenarios[s].observerHeight
+                        << ", \"height2_m\": " << scenarios[s].targetHeight
+                        << ", \"line_of_sight\": " << (results[s].clear ? "true" : "false")
+                        << ", \"fresnel_915mhz_60pct\": " << (results[s + 1].clear ? "true" : "false")
+                        << ", \"fresnel_868mhz_60pct\": " << (results[s + 2].clear ? "true" : "false")
+                        << ", \"margin_m\": [" << results[s].margin << ", " << results[s + 1].margin << ", " << results[s + 2].margin << "]}"
+                        << (s + wavelengths.size() < scenarios.size() ? "," : "") << "\n";
+                }
+                std::cout << "  ],\n";
                 
                 std::cout << "  \"terrain_profile_elev_m\": [";
                     for (size_t i = 0; i < profile.size(); ++i) {
@@ -0,0 +1,135 @@
+#include "../include/multistart_optimizer.hpp"
+#include "../include/coverage.hpp"
+#include <omp.h>
+#include <sstream>
+#include <string>
+
+void MultiStartOptimizer::optimize(unsigned int maxIterations) {
+
+    startTelemetry();
+    stop_reason = optimizer::NOT_STOPPED;
+
+    const unsigned int n = std::max(1u, replicas);
+    const std::size_t num_eds = network.getEndDevices().size();
+
+    // Each replica works on its own copy of the network (the elevation grid is shared)
+    std::vector<network::Network> states(n, network);
+    std::vector<AttractorOptimizer> runs;
+    runs.reserve(n);
+    // Replicas log to their own buffer (disabled if debug output is), merged in replica order after each parallel region
+    std::vector<std::ostringstream> logs(n);
+    auto flushLogs = [&logs]() {
+        for(std::size_t r = 0; r < logs.size(); r++) {
+            std::istringstream lines(logs[r].str());
+            for(std::string line; std::getline(lines, line);)
+                global::dbg << "[replica " << r << "] " << line << std::endl;
+            logs[r].str("");
+        }
+    };
+    // The replicas start from the same end devices, so the matrix of the k-medoids initialization is built once
+    std::shared_ptr<const coverage::CoverageMatrix> matrix;
+    if(initialization == KMEDOIDS_INIT)
+        matrix = std::make_shared<const coverage::CoverageMatrix>(coverage::CoverageMatrix::cached(
+            network, coverage::candidateSites(network), coverage_file));
+    for(unsigned int r = 0; r < n; r++) {
+        if(!global::dbgEnabled()) logs[r].setstate(std::ios::badbit); // Nothing is formatted
+        runs.emplace_back(states[r], rng::stream(r)); // Replica r draws from stream r of the global seed
+        runs[r].setLog(logs[r]);
+        runs[r].setInitialization(initialization);
+        runs[r].setForceMode(force_mode);
+        runs[r].setCoverageFile(coverage_file);
+        runs[r].setCoverageMatrix(matrix);
+        runs[r].setDeadline(deadline);
+        runs[r].start(maxIterations);
+    }
+    flushLogs();
+
+    std::vector<optimizer::Score> progress(n); // Best score of each replica up to the last round
+    std::vector<char> alive(n, 1); // Cleared when a replica is discarded
+    std::vector<char> running(n, 1); // Cleared when a replica finishes or is discarded
+    discarded = 0;
+
+    int outer, inner;
+    global::splitThreads(static_cast<int>(n), outer, inner);
+
+    // Replicas advance in rounds, so discarding only depends on the seed and not on thread timing
+    for(unsigned int round = 0; std::count(running.begin(), running.end(), 1) > 0; round++) {
+
+        #pragma omp parallel for schedule(dynamic) num_threads(outer)
+        for(int r = 0; r < static_cast<int>(n); r++) {
+            if(!running[r]) continue;
+            omp_set_num_threads(inner);
+            for(unsigned int k = 0; k < MULTISTART_ROUND; k++) {
+                if(!runs[r].step()) {
+                    running[r] = 0;
+                    break;
+                }
+            }
+            progress[r] = runs[r].getBestScore(); // What finish() will restore
+        }
+        flushLogs();
+
+        if((round + 1) * MULTISTART_ROUND < MULTISTART_WARMUP) continue;
+
+        // Discard replicas when the best state of another one covers clearly more devices with no more gateways
+        const std::vector<char> candidates = alive;
+        for(unsigned int r = 0; r < n; r++) {
+            if(!running[r]) continue;
+            for(unsigned int q = 0; q < n; q++) {
+                if(q != r && candidates[q] &&
+                   progress[q].connected >= progress[r].connected + MULTISTART_DOMINANCE_MARGIN * num_eds &&
+                   progress[q].gateways <= progress[r].gateways) {
+                    alive[r] = running[r] = 0;
+                    runs[r].discard();
+                    discarded++;
+                    global::dbg << "Replica " << r << " discarded at round " << round << std::endl;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Best state of the replicas (gateways moved after the last connection)
+    #pragma omp parallel for schedule(dynamic) num_threads(outer)
+    for(int r = 0; r < static_cast<int>(n); r++) {
+        omp_set_num_threads(inner);
+        runs[r].finish();
+        progress[r] = optimizer::Score::of(states[r]);
+    }
+    flushLogs();
+
+    unsigned int best = 0;
+    for(unsigned int r = 0; r < n; r++) {
+        global::dbg << "Replica " << r << ": " << progress[r].connected << " connected, "
+                    << progress[r].gateways << " gateways, " << progress[r].distance << " m" << std::endl;
+        if(progress[r].betterThan(progress[best], objective))
+            best = r;
+    }
+
+    global::dbg << "Best replica: " << best << " (" << discarded << " discarded)" << std::endl;
+
+    network = states[best];
+    evaluations = 0;
+    for(const auto& run : runs) {
+        evaluations += run.getEvaluations();
+        snap_failures += run.getSnapFailures();
+    }
+    stop_reason = runs[best].getStopReason();
+    record(runs[best].getIteration(), progress[best]);
+
+    std::vector<std::string> replica_stops;
+    for(const auto& run : runs)
+        replica_stops.push_back(optimizer::stopReasonName(run.getStopReason()));
+
+    network.setProperty("optimization", {
+        {"algorithm", "multistart"},
+        {"replicas", n},
+        {"discarded_replicas", discarded},
+        {"best_replica", best},
+        {"iterations", runs[best].getIteration()},
+        {"snap_failures", snap_failures},
+        {"stop_reason", optimizer::stopReasonName(stop_reason)},
+        {"replica_stop_reasons", replica_stops},
+        {"elapsed_ms", getElapsed()}
+    });
+};
@@ -1,4 +1,5 @@
 #include "../include/network.hpp"
+#include "../include/curves.hpp"
 
 namespace network {
 
@@ -10,14 +11,19 @@ Network Network::fromFeatureCollection(const geojson::FeatureCollection& fc) {
 
     network.gateways.clear();
     network.end_devices.clear();
+    std::vector<geojson::Feature> zone_features;
 
     for (size_t i = 0; i < fc.featureCount(); ++i) {
         const auto& feature = fc.getFeature(i);
         const auto& properties = feature.properties;
 
+        if (feature.geometry_type == geojson::POLYGON || feature.geometry_type == geojson::MULTIPOLYGON) {
+            zone_features.push_back(feature); // Limits where gateways can be placed
+            continue;
+        }
+
         if (feature.geometry_type != geojson::POINT) {
-            // Later we can add support for polygons to limit coverage areas
-            throw std::runtime_error("Invalid GeoJSON: only 'Point' geometry is supported.");
+            throw std::runtime_error("Invalid GeoJSON: only 'Point', 'Polygon' and 'MultiPolygon' geometries are supported.");
         }
 
         if (std::holds_alternative<geojson::Position>(feature.coords)) {
@@ -26,12 +32,13 @@ Network Network::fromFeatureCollection(const geojson::FeatureCollection& fc) {
                 throw std::runtime_error("Invalid Point: must have at least [lon, lat]");
             }
 
-            const Node node = Node::parse(properties, pos[1], pos[0], &network.elevation_grid); // lat, lng
+            const Node node = Node::parse(properties, pos[1], pos[0], network.elevation_grid.get()); // lat, lng
             if (detail::require_string(properties, "type") == "end_device"){
-                network.end_devices.push_back(EndDevice(node.id, node.location, &network.elevation_grid));
+                network.end_devices.push_back(EndDevice(node.id, node.location, network.elevation_grid.get()));
+                network.end_devices.back().input_index = network.end_devices.size() - 1;
             }else{ 
                 if (detail::require_string(properties, "type") == "gateway"){
-                    network.gateways.push_back(Gateway(node.id, node.location, &network.elevation_grid));
+                    network.gateways.push_back(Gateway(node.id, node.location, network.elevation_grid.get()));
                 } else {
                     throw std::runtime_error("Invalid GeoJSON: unknown feature type '" + detail::require_string(properties, "type") + "'");
                 }
@@ -42,10 +49,46 @@ Network Network::fromFeatureCollection(const geojson::FeatureCollection& fc) {
     }
 
     network.bbox = fc.getBBox();
+    network.updateFrame();
+    network.orderEndDevices(HILBERT_ORDER);
+    if (!zone_features.empty())
+        network.site_constraints = std::make_shared<const zones::SiteConstraints>(zone_features);
 
     return network;
 }
 
+Network::Network(const Network& other) {
+    *this = other;
+};
+
+Network& Network::operator=(const Network& other) {
+    if (this != &other) {
+        const std::vector<int> indices = other.assignedGateways();
+        gateways = other.gateways;
+        end_devices = other.end_devices;
+        elevation_grid = other.elevation_grid; // Shared, so nodes keep pointing to a valid grid
+        site_constraints = other.site_constraints;
+        connected_eds_cnt = other.connected_eds_cnt;
+        total_distance = other.total_distance;
+        bbox = other.bbox;
+        frame = other.frame;
+        representative = other.representative;
+        groups = other.groups;
+        los_mode = other.los_mode;
+        los_cells = other.los_cells;
+        properties = other.properties;
+        id_gen = other.id_gen;
+        relink(indices); // Assignment pointers must refer to the copied nodes
+    }
+    return *this;
+};
+
+void Network::setElevationGrid(std::shared_ptr<const terrain::ElevationGrid> grid) {
+    elevation_grid = grid;
+    for (auto& gw : gateways) gw.bindElevationGrid(elevation_grid.get());
+    for (auto& ed : end_devices) ed.bindElevationGrid(elevation_grid.get());
+};
+
 Network Network::fromGeoJSON(const std::string& filepath) {
     auto fc = geojson::FeatureCollection::fromGeoJSON(filepath);
     Network network = Network::fromFeatureCollection(fc);
@@ -53,55 +96,238 @@ Network Network::fromGeoJSON(const std::string& filepath) {
 };
 
 void Network::addGateway(terrain::LatLngAlt pos) {
-    std::string new_id = global::generate_uuid();
-    gateways.push_back(Gateway(new_id, pos, &elevation_grid));
+    std::string new_id = global::generate_uuid(id_gen);
+    gateways.push_back(Gateway(new_id, pos, elevation_grid.get()));
 };
 
-void Network::connect() {
-    // Parallelized version of connect using OpenMP
-    // This function assigns each end device to the closest reachable gateway
+void Network::setGateways(const std::vector<std::string>& ids, const std::vector<terrain::LatLngAlt>& positions) {
+    if (ids.size() != positions.size())
+        throw std::runtime_error("Gateway ids and positions must have the same size");
+    disconnect();
+    gateways.clear();
+    for (size_t i = 0; i < ids.size(); ++i)
+        gateways.push_back(Gateway(ids[i], positions[i], elevation_grid.get()));
+};
 
-    const size_t num_gws = gateways.size();
+std::vector<terrain::LatLngAlt> Network::gatewayLocations() const {
+    std::vector<terrain::LatLngAlt> positions(gateways.size());
+    for (size_t g = 0; g < gateways.size(); ++g) positions[g] = gateways[g].location;
+    return positions;
+};
 
-    if(num_gws == 0) { // No gateways available, all devices remain unassigned
-        for (auto& ed : end_devices) {
-            ed.assigned_gateway = nullptr;
-        }
+std::vector<terrain::LatLngAlt> Network::endDeviceLocations() const {
+    std::vector<terrain::LatLngAlt> positions(end_devices.size());
+    for (size_t e = 0; e < end_devices.size(); ++e) positions[e] = end_devices[e].location;
+    return positions;
+};
+
+std::vector<double> Network::assignmentDistances() const {
+    std::vector<double> distances;
+    terrain::haversineDistances(endDeviceLocations(), gatewayLocations(), assignedGateways(), distances);
+    return distances;
+};
+
+void Network::orderEndDevices(ED_ORDER order) {
+    disconnect();
+    if (end_devices.size() < 2) {
+        groupEndDevices();
+        return;
+    }
+    if (order == INPUT_ORDER) {
+        std::stable_sort(end_devices.begin(), end_devices.end(), [](const EndDevice& a, const EndDevice& b) { return a.input_index < b.input_index; });
+        groupEndDevices();
         return;
     }
 
-    const size_t num_eds = end_devices.size();
+    // Hilbert curve over the bounding box of the end devices
+    double min_lat = DBL_MAX, max_lat = -DBL_MAX, min_lng = DBL_MAX, max_lng = -DBL_MAX;
+    for (const auto& ed : end_devices) {
+        min_lat = std::min(min_lat, ed.location.lat);
+        max_lat = std::max(max_lat, ed.location.lat);
+        min_lng = std::min(min_lng, ed.location.lng);
+        max_lng = std::max(max_lng, ed.location.lng);
+    }
+    const double cells = double((1u << ORDER_BITS) - 1);
+    const double lat_scale = max_lat > min_lat ? cells / (max_lat - min_lat) : 0.0;
+    const double lng_scale = max_lng > min_lng ? cells / (max_lng - min_lng) : 0.0;
+
+    std::vector<std::pair<std::uint64_t, size_t>> keys(end_devices.size());
+    for (size_t e = 0; e < end_devices.size(); ++e) {
+        const auto x = static_cast<std::uint32_t>((end_devices[e].location.lng - min_lng) * lng_scale);
+        const auto y = static_cast<std::uint32_t>((end_devices[e].location.lat - min_lat) * lat_scale);
+        keys[e] = {curves::hilbertKey(x, y, ORDER_BITS), e};
+    }
+    std::sort(keys.begin(), keys.end()); // Ties by current position
 
-    // Parallel per-device search for best gateway
-    std::vector<int> best_gw_idx(num_eds, -1);
-    std::vector<double> best_dist(num_eds, DBL_MAX);
+    std::vector<EndDevice> sorted;
+    sorted.reserve(end_devices.size());
+    for (const auto& key : keys) sorted.push_back(end_devices[key.second]);
+    end_devices = std::move(sorted);
+    groupEndDevices();
+};
+
+PositionKey Network::positionKey(const terrain::LatLngAlt& position) const {
+    const projection::Point point = frame.project(position);
+    return {std::llround(point.x / DEDUP_TOLERANCE), std::llround(point.y / DEDUP_TOLERANCE), std::llround(position.alt / DEDUP_TOLERANCE)};
+};
+
+void Network::groupEndDevices() {
+    groups.clear();
+    representative.resize(end_devices.size());
+    for (size_t e = 0; e < end_devices.size(); ++e) {
+        std::vector<std::uint32_t>& members = groups[positionKey(end_devices[e].location)];
+        members.push_back(static_cast<std::uint32_t>(e)); // Increasing indices, so the first one is the representative
+        representative[e] = members.front();
+    }
+};
 
+void Network::joinGroup(size_t ed_index) {
+    std::vector<std::uint32_t>& members = groups[positionKey(end_devices[ed_index].location)];
+    const auto index = static_cast<std::uint32_t>(ed_index);
+    members.insert(std::lower_bound(members.begin(), members.end(), index), index);
+    if (members.front() == index) { // New representative of the group
+        for (std::uint32_t m : members) representative[m] = index;
+    } else {
+        representative[ed_index] = members.front();
+    }
+};
 
-    #pragma omp parallel for schedule(dynamic) // parallelize over end devices
-    for (int j = 0; j < static_cast<int>(num_eds); ++j) {
-        double minDist = DBL_MAX;
-        int best = -1;
+void Network::leaveGroup(size_t ed_index, const PositionKey& key) {
+    const auto it = groups.find(key);
+    if (it == groups.end()) return;
+    std::vector<std::uint32_t>& members = it->second;
+    const auto index = static_cast<std::uint32_t>(ed_index);
+    const auto member = std::lower_bound(members.begin(), members.end(), index);
+    if (member == members.end() || *member != index) return;
+    members.erase(member);
+    if (members.empty()) {
+        groups.erase(it);
+    } else if (members.front() > index) { // It was the representative, the next one takes over
+        for (std::uint32_t m : members) representative[m] = members.front();
+    }
+    representative[ed_index] = index;
+};
 
-        for (int i = 0; i < static_cast<int>(num_gws); ++i) {
-            const auto& gw = gateways[i];
-            const auto& ed = end_devices[j];
+std::vector<size_t> Network::outputOrder() const {
+    std::vector<size_t> order(end_devices.size());
+    for (size_t e = 0; e < order.size(); ++e) order[e] = e;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return end_devices[a].input_index < end_devices[b].input_index; });
+    return order;
+};
 
-            bool los = gw.lineOfSightTo(ed);
-            //const double distance = gw.distanceTo(ed); // Equirectangular distance
-            const double distance = elevation_grid.squaredDistance(gw.location, ed.location); // Squared distance for efficiency
+void Network::updateFrame() {
+    std::vector<terrain::LatLngAlt> positions = gatewayLocations();
+    const std::vector<terrain::LatLngAlt> ed_positions = endDeviceLocations();
+    positions.insert(positions.end(), ed_positions.begin(), ed_positions.end());
+    frame = projection::LocalFrame::of(positions);
+};
 
-            if (los && distance < minDist) {
-                minDist = distance;
-                best = i;
-            }
+std::vector<projection::Point> Network::projectGateways() const {
+    std::vector<projection::Point> points(gateways.size());
+    for (size_t g = 0; g < gateways.size(); ++g) points[g] = frame.project(gateways[g].location);
+    return points;
+};
+
+projection::Accuracy Network::projectionAccuracy() const {
+    std::vector<terrain::LatLngAlt> positions = gatewayLocations();
+    const std::vector<terrain::LatLngAlt> ed_positions = endDeviceLocations();
+    positions.insert(positions.end(), ed_positions.begin(), ed_positions.end());
+    return frame.accuracy(positions, *elevation_grid, MAX_RANGE);
+};
+
+int Network::bestGateway(const EndDevice& ed, const std::vector<projection::Point>& gw_points) const {
+    double minDist = MAX_RANGE_SQUARED; // Only consider connections within maximum range
+    int best = -1;
+    const projection::Point point = frame.project(ed.location);
+    for (int i = 0; i < static_cast<int>(gateways.size()); ++i) {
+        const auto& gw = gateways[i];
+        const double distance = projection::squaredDistance(gw_points[i], point); // Squared distance for efficiency
+        if (distance < minDist && gw.lineOfSightTo(ed)) { // Distance check first, LOS is the expensive part
+            minDist = distance;
+            best = i;
         }
+    }
+    return best;
+};
+
+void Network::setLineOfSightMode(LOS_MODE mode, unsigned int cells) {
+    if (cells < 1) throw std::invalid_argument("Line of sight cells must be at least 1");
+    los_mode = mode;
+    los_cells = cells;
+};
 
-        // Use MAX_RANGE; -> if use equirectangular distance
-        if(minDist < MAX_RANGE_SQUARED){ // Only consider connections within maximum range
-            best_gw_idx[j] = best;
-            best_dist[j] = minDist;
+std::vector<visibility::Link> Network::linksInRange(const std::vector<projection::Point>& ed_points, const std::vector<projection::Point>& gw_points,
+                                                    std::vector<std::size_t>& offsets) const {
+    // Count the links of each end device, then fill them in place, so the order does not depend on the threads
+    const int num_eds = static_cast<int>(end_devices.size());
+    offsets.assign(end_devices.size() + 1, 0);
+    #pragma omp parallel for schedule(dynamic, CONNECT_CHUNK)
+    for (int e = 0; e < num_eds; ++e) {
+        if (representative[e] != static_cast<std::uint32_t>(e)) continue;
+        for (size_t g = 0; g < gateways.size(); ++g) {
+            if (projection::squaredDistance(gw_points[g], ed_points[e]) < MAX_RANGE_SQUARED)
+                offsets[e + 1]++;
+        }
+    }
+    for (size_t e = 0; e < end_devices.size(); ++e)
+        offsets[e + 1] += offsets[e];
+
+    std::vector<visibility::Link> links(offsets.back());
+    #pragma omp parallel for schedule(dynamic, CONNECT_CHUNK)
+    for (int e = 0; e < num_eds; ++e) {
+        std::size_t l = offsets[e];
+        for (size_t g = 0; l < offsets[e + 1]; ++g) {
+            if (projection::squaredDistance(gw_points[g], ed_points[e]) < MAX_RANGE_SQUARED)
+                links[l++] = {static_cast<std::uint32_t>(g), static_cast<std::uint32_t>(e)};
         }
     }
+    return links;
+};
+
+visibility::Agreement Network::lineOfSightAgreement() const {
+    const std::vector<terrain::LatLngAlt> ed_positions = endDeviceLocations();
+    std::vector<std::size_t> offsets;
+    const std::vector<visibility::Link> links = linksInRange(frame.project(ed_positions), projectGateways(), offsets);
+    return visibility::CellLineOfSight(*elevation_grid, los_cells).agreement(gatewayLocations(), ed_positions, links);
+};
+
+void Network::connect() {
+    // Parallelized version of connect using OpenMP
+    // This function assigns each end device to the closest reachable gateway
+
+    const size_t num_eds = end_devices.size();
+
+    // Parallel per-device search for best gateway
+    std::vector<int> best_gw_idx(num_eds, -1);
+    const std::vector<projection::Point> gw_points = projectGateways(); // Once per call, gateways move between calls
+
+    if (los_mode == CELL_LOS) {
+        // Every link in range is checked (once per pair of cells), then the closest clear one is kept as in bestGateway()
+        const std::vector<terrain::LatLngAlt> ed_positions = endDeviceLocations();
+        const std::vector<projection::Point> ed_points = frame.project(ed_positions);
+        std::vector<std::size_t> offsets;
+        const std::vector<visibility::Link> links = linksInRange(ed_points, gw_points, offsets);
+        const std::vector<char> clear = visibility::CellLineOfSight(*elevation_grid, los_cells).lineOfSight(gatewayLocations(), ed_positions, links);
+        #pragma omp parallel for schedule(dynamic, CONNECT_CHUNK)
+        for (int j = 0; j < static_cast<int>(num_eds); ++j) {
+            double min_dist = MAX_RANGE_SQUARED;
+            for (size_t l = offsets[j]; l < offsets[j + 1]; ++l) { // By increasing gateway index
+                const double distance = projection::squaredDistance(gw_points[links[l].from], ed_points[j]);
+                if (clear[l] && distance < min_dist) {
+                    min_dist = distance;
+                    best_gw_idx[j] = static_cast<int>(links[l].from);
+                }
+            }
+        }
+    } else {
+        #pragma omp parallel for schedule(dynamic, CONNECT_CHUNK) // parallelize over runs of neighbouring end devices
+        for (int j = 0; j < static_cast<int>(num_eds); ++j) {
+            if (representative[j] == static_cast<std::uint32_t>(j))
+                best_gw_idx[j] = bestGateway(end_devices[j], gw_points);
+        }
+    }
+    for (size_t j = 0; j < num_eds; ++j) // Co-located end devices go to the gateway of their representative (which comes first)
+        best_gw_idx[j] = best_gw_idx[representative[j]];
 
     // Reset pointers and connected_eds_cnt
     disconnect();
@@ -114,21 +340,278 @@ void Network::connect() {
             connected_eds_cnt++;
         }
     }
+    total_distance = computeTotalDistance();
 };
 
 void Network::disconnect() {
     for (auto& gw : gateways) gw.connected_devices.clear();
     for (auto& dev : end_devices) dev.assigned_gateway = nullptr;
     connected_eds_cnt = 0;
+    total_distance = 0.0;
 };
 
-double Network::computeTotalDistance() const {
-    double total_distance = 0.0;
-    for (const auto& ed : end_devices) {
-        if (ed.assigned_gateway) {
-            total_distance += ed.distanceTo(*ed.assigned_gateway);
+std::vector<int> Network::assignedGateways() const {
+    std::vector<int> indices(end_devices.size(), -1);
+    for (size_t e = 0; e < end_devices.size(); ++e) {
+        if (end_devices[e].assigned_gateway)
+            indices[e] = static_cast<int>(end_devices[e].assigned_gateway - gateways.data());
+    }
+    return indices;
+};
+
+void Network::relink(const std::vector<int>& gw_indices) {
+    for (auto& gw : gateways) gw.connected_devices.clear();
+    for (size_t e = 0; e < end_devices.size(); ++e) {
+        const int g = gw_indices[e];
+        end_devices[e].assigned_gateway = g >= 0 ? &gateways[g] : nullptr;
+        if (g >= 0) gateways[g].connected_devices.push_back(&end_devices[e]);
+    }
+};
+
+void Network::assign(size_t ed_index, int gw_index, Delta& changes) {
+    EndDevice& ed = end_devices[ed_index];
+    if (ed.assigned_gateway) { // Detach from current gateway
+        auto& list = ed.assigned_gateway->connected_devices;
+        list.erase(std::find(list.begin(), list.end(), &ed));
+        total_distance -= ed.distanceTo(*ed.assigned_gateway);
+        connected_eds_cnt--;
+        ed.assigned_gateway = nullptr;
+    }
+
+    Assignment change{ed.id, "", 0.0};
+    if (gw_index >= 0) {
+        ed.assigned_gateway = &gateways[gw_index];
+        gateways[gw_index].connected_devices.push_back(&ed);
+        change.gateway_id = gateways[gw_index].id;
+        change.distance = ed.distanceTo(gateways[gw_index]);
+        total_distance += change.distance;
+        connected_eds_cnt++;
+    }
+    changes.push_back(change);
+};
+
+Assignment Network::assignmentOf(size_t ed_index) const {
+    const EndDevice& ed = end_devices[ed_index];
+    if (!ed.assigned_gateway) return {ed.id, "", 0.0};
+    return {ed.id, ed.assigned_gateway->id, ed.distanceTo(*ed.assigned_gateway)};
+};
+
+Delta Network::netChanges(const Delta& changes, const Delta& before) {
+    std::unordered_map<std::string, size_t> slot; // Position of each end device in the result
+    Delta result;
+    for (const auto& change : changes) {
+        const auto it = slot.find(change.end_device_id);
+        if (it == slot.end()) {
+            slot.emplace(change.end_device_id, result.size());
+            result.push_back(change);
+        } else {
+            result[it->second] = change;
         }
     }
+    std::unordered_map<std::string, const Assignment*> previous;
+    for (const auto& assignment : before) previous.emplace(assignment.end_device_id, &assignment);
+    result.erase(std::remove_if(result.begin(), result.end(), [&](const Assignment& a) {
+        const auto it = previous.find(a.end_device_id);
+        return it != previous.end() && it->second->gateway_id == a.gateway_id && it->second->distance == a.distance;
+    }), result.end());
+    return result;
+};
+
+void Network::checkNewId(const std::string& id) const {
+    if (findEndDevice(id) >= 0 || findGateway(id) >= 0)
+        throw std::runtime_error("Node id '" + id + "' already exists");
+};
+
+Delta Network::addEndDevice(const std::string& id, terrain::LatLngAlt pos) {
+    checkNewId(id);
+    const bool first = end_devices.empty() && gateways.empty();
+    std::vector<int> indices = assignedGateways();
+    size_t input_index = 0;
+    for (const auto& ed : end_devices) input_index = std::max(input_index, ed.input_index + 1);
+    end_devices.push_back(EndDevice(id, pos, elevation_grid.get()));
+    end_devices.back().input_index = input_index; // Output after the existing ones
+    indices.push_back(-1);
+    relink(indices); // Gateways hold pointers to end devices
+    if (first) updateFrame(); // Networks built empty get their frame from the first node
+    representative.push_back(static_cast<std::uint32_t>(end_devices.size() - 1));
+    joinGroup(end_devices.size() - 1);
+
+    Delta changes;
+    assign(end_devices.size() - 1, bestGateway(end_devices.back(), projectGateways()), changes);
+    return changes;
+};
+
+Delta Network::addGateway(const std::string& id, terrain::LatLngAlt pos) {
+    checkNewId(id);
+    const bool first = end_devices.empty() && gateways.empty();
+    std::vector<int> indices = assignedGateways();
+    gateways.push_back(Gateway(id, pos, elevation_grid.get()));
+    relink(indices); // End devices hold pointers to gateways
+    if (first) updateFrame();
+
+    const int g = static_cast<int>(gateways.size()) - 1;
+    Delta changes;
+    const std::vector<char> closer = improvedBy(g);
+    for (size_t e = 0; e < end_devices.size(); ++e) {
+        if (closer[e]) assign(e, g, changes);
+    }
+    return changes;
+};
+
+Delta Network::moveEndDevice(size_t index, terrain::LatLngAlt pos) {
+    if (index >= end_devices.size()) throw std::out_of_range("End device index out of range");
+    const Delta before = {assignmentOf(index)};
+    Delta changes, detached;
+    assign(index, -1, detached); // Remove distance to current gateway before moving
+    leaveGroup(index, positionKey(end_devices[index].location));
+    end_devices[index].location = pos;
+    joinGroup(index);
+    assign(index, bestGateway(end_devices[index], projectGateways()), changes);
+    return netChanges(changes, before);
+};
+
+Delta Network::moveGateway(size_t index, terrain::LatLngAlt pos) {
+    if (index >= gateways.size()) throw std::out_of_range("Gateway index out of range");
+
+    // Devices of the moved gateway must look for the best gateway again
+    std::vector<size_t> affected;
+    for (const auto* ed : gateways[index].connected_devices)
+        affected.push_back(static_cast<size_t>(ed - end_devices.data()));
+    Delta before;
+    for (size_t e : affected) before.push_back(assignmentOf(e));
+    Delta changes, detached;
+    for (size_t e : affected) assign(e, -1, detached);
+
+    gateways[index].location = pos;
+
+    std::vector<int> best(affected.size(), -1);
+    const std::vector<projection::Point> gw_points = projectGateways();
+    #pragma omp parallel for schedule(dynamic)
+    for (int k = 0; k < static_cast<int>(affected.size()); ++k) {
+        best[k] = bestGateway(end_devices[affected[k]], gw_points);
+    }
+    for (size_t k = 0; k < affected.size(); ++k) assign(affected[k], best[k], changes);
+
+    // The rest only need to compare their gateway against the new position
+    const std::vector<char> closer = improvedBy(static_cast<int>(index));
+    for (size_t e = 0; e < end_devices.size(); ++e) {
+        if (closer[e]) assign(e, static_cast<int>(index), changes);
+    }
+    return netChanges(changes, before); // Devices that stay with the gateway at the same distance are not reported
+};
+
+Delta Network::removeEndDevice(size_t index) {
+    if (index >= end_devices.size()) throw std::out_of_range("End device index out of range");
+    Delta changes;
+    assign(index, -1, changes); // Reported as disconnected
+
+    leaveGroup(index, positionKey(end_devices[index].location));
+    std::vector<int> indices = assignedGateways();
+    indices.erase(indices.begin() + index);
+    end_devices.erase(end_devices.begin() + index);
+    relink(indices);
+
+    // Following end devices moved one position back, their groups keep the same order
+    const auto removed = static_cast<std::uint32_t>(index);
+    representative.erase(representative.begin() + index);
+    for (auto& r : representative) {
+        if (r > removed) r--;
+    }
+    for (auto& group : groups) {
+        for (auto& m : group.second) {
+            if (m > removed) m--;
+        }
+    }
+    return changes;
+};
+
+Delta Network::removeGateway(size_t index) {
+    if (index >= gateways.size()) throw std::out_of_range("Gateway index out of range");
+
+    std::vector<size_t> affected;
+    for (const auto* ed : gateways[index].connected_devices)
+        affected.push_back(static_cast<size_t>(ed - end_devices.data()));
+    Delta changes, detached;
+    for (size_t e : affected) assign(e, -1, detached);
+
+    std::vector<int> indices = assignedGateways();
+    for (auto& g : indices) {
+        if (g > static_cast<int>(index)) g--;
+    }
+    gateways.erase(gateways.begin() + index);
+    relink(indices);
+
+    std::vector<int> best(affected.size(), -1);
+    const std::vector<projection::Point> gw_points = projectGateways();
+    #pragma omp parallel for schedule(dynamic)
+    for (int k = 0; k < static_cast<int>(affected.size()); ++k) {
+        best[k] = bestGateway(end_devices[affected[k]], gw_points);
+    }
+    for (size_t k = 0; k < affected.size(); ++k) assign(affected[k], best[k], changes);
+    return changes;
+};
+
+Delta Network::moveNode(const std::string& id, terrain::LatLngAlt pos) {
+    const int e = findEndDevice(id);
+    if (e >= 0) return moveEndDevice(e, pos);
+    const int g = findGateway(id);
+    if (g >= 0) return moveGateway(g, pos);
+    throw std::runtime_error("Unknown node id '" + id + "'");
+};
+
+Delta Network::removeNode(const std::string& id) {
+    const int e = findEndDevice(id);
+    if (e >= 0) return removeEndDevice(e);
+    const int g = findGateway(id);
+    if (g >= 0) return removeGateway(g);
+    throw std::runtime_error("Unknown node id '" + id + "'");
+};
+
+int Network::findEndDevice(const std::string& id) const {
+    for (size_t e = 0; e < end_devices.size(); ++e) {
+        if (end_devices[e].id == id) return static_cast<int>(e);
+    }
+    return -1;
+};
+
+int Network::findGateway(const std::string& id) const {
+    for (size_t g = 0; g < gateways.size(); ++g) {
+        if (gateways[g].id == id) return static_cast<int>(g);
+    }
+    return -1;
+};
+
+std::vector<char> Network::improvedBy(int gw_index) const {
+    const auto& gw = gateways[gw_index];
+    std::vector<char> closer(end_devices.size(), 0);
+    const std::vector<projection::Point> gw_points = projectGateways();
+
+    auto check = [&](int e) {
+        const auto& ed = end_devices[e];
+        if (ed.assigned_gateway == &gw) return;
+        const projection::Point point = frame.project(ed.location);
+        const double distance = projection::squaredDistance(gw_points[gw_index], point);
+        const double current = ed.assigned_gateway ? 
+            projection::squaredDistance(gw_points[ed.assigned_gateway - gateways.data()], point) : MAX_RANGE_SQUARED;
+        if (distance < current && gw.lineOfSightTo(ed)) closer[e] = 1;
+    };
+
+    #pragma omp parallel for schedule(dynamic) // parallelize over end devices, representatives first
+    for (int e = 0; e < static_cast<int>(end_devices.size()); ++e) {
+        if (representative[e] == static_cast<std::uint32_t>(e)) check(e);
+    }
+    #pragma omp parallel for schedule(dynamic)
+    for (int e = 0; e < static_cast<int>(end_devices.size()); ++e) {
+        const std::uint32_t r = representative[e];
+        if (r == static_cast<std::uint32_t>(e)) continue;
+        if (end_devices[e].assigned_gateway == end_devices[r].assigned_gateway) closer[e] = closer[r];
+        else check(e); // Assigned apart from its group (not expected after connect())
+    }
+    return closer;
+};
+double Network::computeTotalDistance() const {
+    double total_distance = 0.0;
+    for (double distance : assignmentDistances()) total_distance += distance; // 0 for the not connected ones
     return total_distance;
 };
 
@@ -143,8 +626,10 @@ geojson::FeatureCollection Network::toFeatureCollection() const {
 
     // Add gateways
     for (const auto& gw : gateways) {
+        std::vector<const EndDevice*> connected(gw.connected_devices.begin(), gw.connected_devices.end());
+        std::stable_sort(connected.begin(), connected.end(), [](const EndDevice* a, const EndDevice* b) { return a->input_index < b->input_index; });
         std::vector<std::string> connected_device_ids;
-        for(const auto& dev : gw.connected_devices) {
+        for(const auto* dev : connected) {
             connected_device_ids.push_back(dev->id);
         }
         geojson::Feature gw_location;
@@ -164,7 +649,9 @@ geojson::FeatureCollection Network::toFeatureCollection() const {
     }
 
     // Add end devices and connections to assigned gateways (if any)
-    for (const auto& ed : end_devices) {
+    const std::vector<double> distances = assignmentDistances();
+    for (size_t e : outputOrder()) {
+        const auto& ed = end_devices[e];
         geojson::Feature ed_location;
         ed_location.geometry_type = geojson::POINT;
         ed_location.properties = nlohmann::json{
@@ -181,7 +668,7 @@ geojson::FeatureCollection Network::toFeatureCollection() const {
                 {"type", "connection"},
                 {"from", ed.id},
                 {"to", ed.assigned_gateway->id},
-                {"distance", ed.distanceTo(*ed.assigned_gateway)}
+                {"distance", distances[e]}
             };
             connection.coords = geojson::LineString{
                 geojson::Position{ed.location.lng, ed.location.lat}, 
@@ -198,9 +685,12 @@ geojson::FeatureCollection Network::toFeatureCollection() const {
         if (ed.location.lng > maxLng) maxLng = ed.location.lng;
     }
 
+    for (const auto& zone : site_constraints->getFeatures())
+        feature_collection.addFeature(zone);
+
     feature_collection.setBBox({minLng, minLat, maxLng, maxLat});
 
-    feature_collection.setProperties({
+    nlohmann::json fc_properties = {
         {"num_gateways", gateways.size()},
         {"num_end_devices", end_devices.size()},
         {"total_distance", computeTotalDistance()},
@@ -208,17 +698,21 @@ geojson::FeatureCollection Network::toFeatureCollection() const {
         {"disconnected_end_devices", static_cast<int>(std::count_if(end_devices.begin(), end_devices.end(), [](const EndDevice& ed){ return ed.assigned_gateway == nullptr; }))},
         {"elevation_grid", {
             {"bounding_box", {
-                {"upper_right", {elevation_grid.getBoundingBox()[0].lat, elevation_grid.getBoundingBox()[0].lng}},
-                {"bottom_left", {elevation_grid.getBoundingBox()[2].lat, elevation_grid.getBoundingBox()[2].lng}}
+                {"upper_right", {elevation_grid->getBoundingBox()[0].lat, elevation_grid->getBoundingBox()[0].lng}},
+                {"bottom_left", {elevation_grid->getBoundingBox()[2].lat, elevation_grid->getBoundingBox()[2].lng}}
             }},
-            {"altitude_range", {elevation_grid.getMinAltitude(), elevation_grid.getMaxAltitude()}}
+            {"altitude_range", {elevation_grid->getMinAltitude(), elevation_grid->getMaxAltitude()}}
         }},
         {"max_connection_distance", MAX_RANGE},
+        {"end_device_positions", groups.size()},
+        {"dedup_ratio", groups.size() > 0 ? double(end_devices.size()) / groups.size() : 1.0},
         {"network_bbox", {
             {"upper_right", {maxLat, maxLng}},
             {"bottom_left", {minLat, minLng}}
         }}
-    });
+    };
+    fc_properties.update(properties);
+    feature_collection.setProperties(fc_properties);
 
     return feature_collection;
 };
@@ -234,22 +728,27 @@ void Network::printPlainText() const {
                   << "    Connected End Devices: " << gw.connected_devices.size() << std::endl;
     }
     std::cout << "Number of End Devices: " << end_devices.size() << std::endl;
-    for (const auto& ed : end_devices) {
+    const std::vector<double> distances = assignmentDistances();
+    for (size_t e : outputOrder()) {
+        const auto& ed = end_devices[e];
         std::cout << "  End Device ID: " << ed.id << std::endl
                   << "    Lat: " << ed.location.lat << std::endl
                   << "    Lng: " << ed.location.lng << std::endl 
                   << "    Height: " << ed.location.alt << "m" << std::endl
                   << "    Assigned Gateway: " 
                   << (ed.assigned_gateway ? ed.assigned_gateway->id : "None") << std::endl;
-        std::cout << "    Distance to Gateway: " << (ed.assigned_gateway ? std::to_string(ed.distanceTo(*ed.assigned_gateway)) + " meters" : "N/A")
+        std::cout << "    Distance to Gateway: " << (ed.assigned_gateway ? std::to_string(distances[e]) + " meters" : "N/A")
                   << std::endl;
     }
     std::cout << "Terrain Elevation Grid:" << std::endl;
     std::cout << "   Bounding Box:" << std::endl;
-    std::cout << "      Upper right position: [" << elevation_grid.getBoundingBox()[0].lat << ", " << elevation_grid.getBoundingBox()[0].lng << "]" << std::endl;
-    std::cout << "      Bottom left position: [" << elevation_grid.getBoundingBox()[2].lat << ", " << elevation_grid.getBoundingBox()[2].lng << "]" << std::endl;
-    std::cout << "      Altitude range: [" << elevation_grid.getMinAltitude() << ", " << elevation_grid.getMaxAltitude() << "] meters" << std::endl;
+    std::cout << "      Upper right position: [" << elevation_grid->getBoundingBox()[0].lat << ", " << elevation_grid->getBoundingBox()[0].lng << "]" << std::endl;
+    std::cout << "      Bottom left position: [" << elevation_grid->getBoundingBox()[2].lat << ", " << elevation_grid->getBoundingBox()[2].lng << "]" << std::endl;
+    std::cout << "      Altitude range: [" << elevation_grid->getMinAltitude() << ", " << elevation_grid->getMaxAltitude() << "] meters" << std::endl;
     std::cout << "Total distance from end devices to assigned gateways: " << computeTotalDistance() << " meters" << std::endl;
+    for (const auto& item : properties.items()) {
+        std::cout << item.key() << ": " << item.value().dump() << std::endl;
+    }
     std::cout << "----------------------------------------" << std::endl;
 
     // Print distance matrix
@@ -259,14 +758,13 @@ void Network::printPlainText() const {
         std::cout << "," << gateways[g].id;
     }
     std::cout << std::endl;
-    for(size_t e = 0; e < end_devices.size(); e++) {
+    std::vector<double> matrix;
+    terrain::equirectangularMatrix(endDeviceLocations(), gatewayLocations(), matrix);
+    for(size_t e : outputOrder()) {
         std::cout << end_devices[e].id;
         for(size_t g = 0; g < gateways.size(); g++) {
-            double dist = elevation_grid.equirectangularDistance(
-                getEndDeviceLocation(e),
-                getGatewayLocation(g)
-            );
-            if(elevation_grid.lineOfSight(
+            double dist = matrix[e * gateways.size() + g];
+            if(elevation_grid->lineOfSight(
                 getEndDeviceLocation(e),
                 getGatewayLocation(g)
             )) {
@@ -0,0 +1,107 @@
+#include "../include/projection.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace projection {
+
+nlohmann::json Accuracy::toJSON() const {
+    return {
+        {"pairs", pairs},
+        {"extent", extent},
+        {"max_error", max_error},
+        {"max_relative_error", max_relative_error},
+        {"mean_relative_error", mean_relative_error},
+        {"range_pairs", range_pairs},
+        {"range_disagreements", range_disagreements},
+        {"batch_haversine_error", batch_haversine_error},
+        {"batch_equirectangular_error", batch_equirectangular_error},
+        {"batch_slant_range_error", batch_slant_range_error},
+        {"batch_within_tolerance", batchWithinTolerance()}
+    };
+};
+
+LocalFrame::LocalFrame(double lat, double lng) : origin_lat(lat), origin_lng(lng) {
+    sin_lat = std::sin(global::toRadians(lat));
+    cos_lat = std::cos(global::toRadians(lat));
+};
+
+LocalFrame LocalFrame::of(const std::vector<terrain::LatLngAlt>& positions) {
+    if(positions.empty())
+        return LocalFrame();
+    double min_lat = std::numeric_limits<double>::max(), max_lat = std::numeric_limits<double>::lowest();
+    double min_lng = std::numeric_limits<double>::max(), max_lng = std::numeric_limits<double>::lowest();
+    for(const auto& p : positions) {
+        min_lat = std::min(min_lat, p.lat);
+        max_lat = std::max(max_lat, p.lat);
+        min_lng = std::min(min_lng, p.lng);
+        max_lng = std::max(max_lng, p.lng);
+    }
+    return LocalFrame((min_lat + max_lat) / 2, (min_lng + max_lng) / 2);
+};
+
+std::vector<Point> LocalFrame::project(const std::vector<terrain::LatLngAlt>& positions) const {
+    std::vector<Point> points(positions.size());
+    #pragma omp parallel for schedule(static)
+    for(int i = 0; i < static_cast<int>(positions.size()); i++)
+        points[i] = project(positions[i]);
+    return points;
+};
+
+Accuracy LocalFrame::accuracy(const std::vector<terrain::LatLngAlt>& positions, const terrain::ElevationGrid& grid, double range) const {
+    // Evenly spaced sample, every pair of it
+    std::vector<terrain::LatLngAlt> sample;
+    const std::size_t stride = std::max<std::size_t>(1, (positions.size() + PROJECTION_ACCURACY_SAMPLES - 1) / PROJECTION_ACCURACY_SAMPLES);
+    for(std::size_t i = 0; i < positions.size(); i += stride)
+        sample.push_back(positions[i]);
+    const std::vector<Point> points = project(sample);
+
+    Accuracy report;
+    double sum_relative_error = 0.0;
+    const double range_squared = range * range;
+    for(std::size_t i = 0; i < sample.size(); i++) {
+        for(std::size_t j = i + 1; j < sample.size(); j++) {
+            const double reference = grid.haversineDistance(sample[i], sample[j]);
+            const double planar_squared = squaredDistance(points[i], points[j]);
+            const double error = std::abs(std::sqrt(planar_squared) - reference);
+            report.pairs++;
+            report.extent = std::max(report.extent, reference);
+            report.max_error = std::max(report.max_error, error);
+            if(reference > 0.0) {
+                report.max_relative_error = std::max(report.max_relative_error, error / reference);
+                sum_relative_error += error / reference;
+            }
+            if(reference < range) report.range_pairs++;
+            if((reference < range) != (planar_squared < range_squared)) report.range_disagreements++;
+        }
+    }
+    if(report.pairs > 0)
+        report.mean_relative_error = sum_relative_error / report.pairs;
+
+    // Batch kernels on every pair of the sample, in both forms: the matrix at once and the indexed one a column at a time
+    using Batch = void (*)(const std::vector<terrain::LatLngAlt>&, const std::vector<terrain::LatLngAlt>&, const std::vector<int>&, std::vector<double>&);
+    using BatchMatrix = void (*)(const std::vector<terrain::LatLngAlt>&, const std::vector<terrain::LatLngAlt>&, std::vector<double>&);
+    auto batchError = [&](Batch indexed, BatchMatrix matrix, auto scalar) {
+        double max_error = 0.0;
+        std::vector<double> batch, column;
+        std::vector<int> index(sample.size());
+        matrix(sample, sample, batch);
+        for(std::size_t j = 0; j < sample.size(); j++) {
+            std::fill(index.begin(), index.end(), static_cast<int>(j));
+            indexed(sample, sample, index, column);
+            for(std::size_t i = 0; i < sample.size(); i++) {
+                const double reference = scalar(sample[i], sample[j]);
+                max_error = std::max({max_error, std::abs(batch[i * sample.size() + j] - reference), std::abs(column[i] - reference)});
+            }
+        }
+        return max_error;
+    };
+    report.batch_haversine_error = batchError(terrain::haversineDistances, terrain::haversineMatrix,
+        [&](const terrain::LatLngAlt& a, const terrain::LatLngAlt& b) { return grid.haversineDistance(a, b); });
+    report.batch_equirectangular_error = batchError(terrain::equirectangularDistances, terrain::equirectangularMatrix,
+        [&](const terrain::LatLngAlt& a, const terrain::LatLngAlt& b) { return grid.equirectangularDistance(a, b); });
+    report.batch_slant_range_error = batchError(terrain::slantRanges, terrain::slantRangeMatrix,
+        [&](const terrain::LatLngAlt& a, const terrain::LatLngAlt& b) { return grid.straightLineDistance(a, b); });
+    return report;
+};
+
+} // namespace projection
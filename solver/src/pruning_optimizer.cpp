@@ -0,0 +1,103 @@
+#include "../include/pruning_optimizer.hpp"
+#include <algorithm>
+
+void PruningOptimizer::optimize(unsigned int maxLoss) {
+
+    startTelemetry();
+    stop_reason = optimizer::NOT_STOPPED;
+    removed_count = 0;
+
+    network.connect();
+    const optimizer::Score initial = optimizer::Score::of(network);
+    record(0, initial);
+
+    const auto& eds = network.getEndDevices();
+    const auto& gws = network.getGateways();
+    const std::size_t num_gateways = gws.size();
+
+    // End devices each gateway can reach, same criteria as Network::connect()
+    std::vector<std::vector<std::uint32_t>> reach(num_gateways);
+    std::vector<projection::Point> ed_points(eds.size());
+    const auto& representative = network.getRepresentatives();
+    for(std::size_t e = 0; e < eds.size(); e++)
+        ed_points[e] = network.getFrame().project(eds[e].location);
+    #pragma omp parallel for schedule(dynamic) // parallelize over gateways
+    for(std::size_t g = 0; g < num_gateways; g++) {
+        const projection::Point point = network.getFrame().project(gws[g].location);
+        for(std::uint32_t e = 0; e < eds.size(); e++) {
+            if(representative[e] != e) { // Co-located with an end device already checked
+                if(std::binary_search(reach[g].begin(), reach[g].end(), representative[e]))
+                    reach[g].push_back(e);
+                continue;
+            }
+            if(projection::squaredDistance(point, ed_points[e]) < network::MAX_RANGE_SQUARED && gws[g].lineOfSightTo(eds[e]))
+                reach[g].push_back(e);
+        }
+    }
+    evaluations = num_gateways;
+
+    // Gateways reaching each device, the xor of their indices is the only one when the count is 1
+    std::vector<std::uint32_t> count(eds.size(), 0);
+    std::vector<std::size_t> owner(eds.size(), 0);
+    for(std::size_t g = 0; g < num_gateways; g++) {
+        for(std::uint32_t e : reach[g]) {
+            count[e]++;
+            owner[e] ^= g;
+        }
+    }
+    std::vector<std::size_t> loss(num_gateways, 0);
+    for(std::size_t e = 0; e < eds.size(); e++) {
+        if(count[e] == 1)
+            loss[owner[e]]++;
+    }
+
+    std::vector<char> removed(num_gateways, 0);
+    std::size_t lost = 0;
+    while(true) {
+        if(deadlineReached()) {
+            global::dbg << "Time limit reached after removing " << removed_count << " gateways" << std::endl;
+            stop_reason = optimizer::TIME_LIMIT;
+            break;
+        }
+
+        // Least loss, then the gateway reaching fewer devices, then the last one added
+        std::size_t best = num_gateways;
+        for(std::size_t g = first; g < num_gateways; g++) {
+            if(removed[g] || lost + loss[g] > maxLoss) continue;
+            if(best == num_gateways || loss[g] < loss[best] || 
+               (loss[g] == loss[best] && reach[g].size() <= reach[best].size()))
+                best = g;
+        }
+        if(best == num_gateways) break;
+
+        removed[best] = 1;
+        removed_count++;
+        lost += loss[best];
+        for(std::uint32_t e : reach[best]) {
+            count[e]--;
+            owner[e] ^= best;
+            if(count[e] == 1) // The remaining gateway is now the only one reaching it
+                loss[owner[e]]++;
+        }
+
+        global::dbg << "Removed gateway " << gws[best].id << " (" << loss[best] << " end devices lost)" << std::endl;
+    }
+
+    if(stop_reason == optimizer::NOT_STOPPED)
+        stop_reason = optimizer::CONVERGED;
+
+    // Devices of the removed gateways go to their closest remaining gateway, the others keep their assignment
+    for(std::size_t g = num_gateways; g-- > first;) {
+        if(removed[g])
+            network.removeGateway(g);
+    }
+    record(removed_count, optimizer::Score::of(network));
+
+    network.setProperty("pruning", {
+        {"gateways_removed", removed_count},
+        {"end_devices_lost", initial.connected - network.getConnectedEdCount()},
+        {"max_loss", maxLoss},
+        {"stop_reason", optimizer::stopReasonName(stop_reason)},
+        {"elapsed_ms", getElapsed()}
+    });
+};
@@ -0,0 +1,160 @@
+#include "../include/registry.hpp"
+#include "../include/multistart_optimizer.hpp"
+#include "../include/greedy_optimizer.hpp"
+#include "../include/exact_optimizer.hpp"
+#include "../include/annealing_optimizer.hpp"
+#include "../include/genetic_optimizer.hpp"
+#include "../include/swarm_optimizer.hpp"
+#include <stdexcept>
+
+namespace optimizer {
+
+namespace {
+
+Result resultOf(const std::string& name, const Optimizer& opt, const network::Network& net) {
+    Result result;
+    result.algorithm = name;
+    result.score = Score::of(net);
+    result.stop_reason = opt.getStopReason();
+    result.elapsed_ms = opt.getElapsed();
+    result.evaluations = opt.getEvaluations();
+    result.snap_failures = opt.getSnapFailures();
+    result.telemetry = opt.getTelemetry();
+    return result;
+}
+
+// Optimizers of the coverage matrix share the same setup
+template <typename T>
+Result runSiteSelection(const std::string& name, network::Network& net, const Parameters& params) {
+    T opt(net);
+    opt.setCoverageFile(params.coverage_file);
+    opt.setDeadline(params.deadline);
+    if(params.iterations > 0)
+        opt.optimize(params.iterations);
+    else
+        opt.optimize();
+    return resultOf(name, opt, net);
+}
+
+std::vector<Algorithm> builtins() {
+    return {
+        {"attractor", "gateways are attracted by the end devices and added when the system stagnates (iterations)",
+            [](network::Network& net, const Parameters& params) {
+                AttractorOptimizer opt(net);
+                opt.setInitialization(params.initialization);
+                opt.setForceMode(params.force_mode);
+                opt.setCoverageFile(params.coverage_file);
+                opt.setDeadline(params.deadline);
+                if(!params.checkpoint_file.empty())
+                    opt.setCheckpoint(params.checkpoint_file, params.checkpoint_interval);
+                const unsigned int iterations = params.iterations > 0 ? params.iterations : 500;
+                if(params.resume_file.empty()) {
+                    opt.optimize(iterations);
+                } else {
+                    opt.resume(params.resume_file, iterations);
+                    while(opt.step());
+                    opt.finish();
+                }
+                return resultOf("attractor", opt, net);
+            }},
+        {"multistart", "independent attractor replicas, the best one is kept (iterations)",
+            [](network::Network& net, const Parameters& params) {
+                MultiStartOptimizer opt(net, params.starts > 0 ? params.starts : MULTISTART_REPLICAS, params.objective);
+                opt.setInitialization(params.initialization);
+                opt.setForceMode(params.force_mode);
+                opt.setCoverageFile(params.coverage_file);
+                opt.setDeadline(params.deadline);
+                opt.optimize(params.iterations > 0 ? params.iterations : 500);
+                return resultOf("multistart", opt, net);
+            }},
+        {"greedy", "lazy greedy set cover over candidate sites (gateways)",
+            [](network::Network& net, const Parameters& params) { return runSiteSelection<GreedyOptimizer>("greedy", net, params); }},
+        {"exact", "branch and bound set cover over candidate sites (time limit)",
+            [](network::Network& net, const Parameters& params) {
+                ExactOptimizer opt(net);
+                opt.setCoverageFile(params.coverage_file);
+                opt.setDeadline(params.deadline);
+                opt.optimize(); // Bounded by its own time limit and the deadline
+                return resultOf("exact", opt, net);
+            }},
+        {"annealing", "simulated annealing over candidate sites (moves)",
+            [](network::Network& net, const Parameters& params) { return runSiteSelection<AnnealingOptimizer>("annealing", net, params); }},
+        {"genetic", "genetic algorithm over sets of candidate sites (generations)",
+            [](network::Network& net, const Parameters& params) { return runSiteSelection<GeneticOptimizer>("genetic", net, params); }},
+        {"swarm", "particle swarm over continuous gateway coordinates (iterations)",
+            [](network::Network& net, const Parameters& params) {
+                SwarmOptimizer opt(net);
+                opt.setDeadline(params.deadline);
+                if(params.iterations > 0)
+                    opt.optimize(params.iterations);
+                else
+                    opt.optimize();
+                return resultOf("swarm", opt, net);
+            }}
+    };
+}
+
+std::vector<Algorithm>& registry() {
+    static std::vector<Algorithm> entries = builtins();
+    return entries;
+}
+
+} // namespace
+
+nlohmann::json Result::toJSON(bool withTelemetry) const {
+    nlohmann::json data = {
+        {"algorithm", algorithm},
+        {"connected", score.connected},
+        {"gateways", score.gateways},
+        {"distance", score.distance},
+        {"stop_reason", stopReasonName(stop_reason)},
+        {"elapsed_ms", elapsed_ms},
+        {"evaluations", evaluations},
+        {"evaluations_per_second", evaluationsPerSecond()},
+        {"snap_failures", snap_failures}
+    };
+    if(withTelemetry) {
+        data["telemetry"] = nlohmann::json::array();
+        for(const auto& sample : telemetry)
+            data["telemetry"].push_back({sample.iteration, sample.elapsed_ms, sample.best.connected, sample.best.gateways, sample.best.distance});
+    }
+    return data;
+};
+
+const std::vector<Algorithm>& algorithms() {
+    return registry();
+};
+
+const Algorithm* findAlgorithm(const std::string& name) {
+    for(const auto& algorithm : registry()) {
+        if(algorithm.name == name)
+            return &algorithm;
+    }
+    return nullptr;
+};
+
+std::string algorithmNames() {
+    std::string names;
+    for(const auto& algorithm : registry())
+        names += (names.empty() ? "" : ", ") + algorithm.name;
+    return names;
+};
+
+void registerAlgorithm(const Algorithm& algorithm) {
+    for(auto& entry : registry()) {
+        if(entry.name == algorithm.name) {
+            entry = algorithm;
+            return;
+        }
+    }
+    registry().push_back(algorithm);
+};
+
+Result run(const std::string& name, network::Network& net, const Parameters& params) {
+    const Algorithm* algorithm = findAlgorithm(name);
+    if(algorithm == nullptr)
+        throw std::runtime_error("Unknown algorithm '" + name + "'. Supported algorithms: " + algorithmNames());
+    return algorithm->run(net, params);
+};
+
+} // namespace optimizer
@@ -0,0 +1,26 @@
+#include "../include/rng.hpp"
+#include <random>
+
+namespace rng {
+
+namespace {
+    bool seeded = false;
+    std::uint64_t global_seed = 0;
+}
+
+void setSeed(std::uint64_t seed) {
+    global_seed = seed;
+    seeded = true;
+};
+
+std::uint64_t getSeed() {
+    #pragma omp critical(rng_seed)
+    if (!seeded) {
+        std::random_device rd;
+        global_seed = (static_cast<std::uint64_t>(rd()) << 32) | rd();
+        seeded = true;
+    }
+    return global_seed;
+};
+
+} // namespace rng
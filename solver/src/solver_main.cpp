@@ -2,19 +2,36 @@
 
 #include <iostream>
 #include <cstring>
+#include <chrono>
+#include <cstdlib>
+#include <cerrno>
 
 #include "../include/json.hpp"
 #include "../include/global.hpp"
 #include "../include/terrain.hpp"
 #include "../include/network.hpp"
-#include "../include/attractor_optimizer.h"
+#include "../include/registry.hpp"
+#include "../include/pruning_optimizer.hpp"
 
 
 int main(int argc, char **argv) {
 
+    const auto start_time = std::chrono::steady_clock::now(); // The time limit includes loading the files
     std::string em_filename; // Terrain elevation model file (csv)
     std::string nw_filename; // Network file (geojson)
-    int max_iterations = 500; // Max iterations for the optimizers
+    int max_iterations = 0; // Budget of the optimizer (iterations, generations, moves or gateways), 0 for its default
+    std::string algorithm = "attractor"; // Optimization algorithm
+    std::string coverage_filename; // Cache of the coverage matrix for site selection algorithms
+    int starts = 0; // Independent optimizer runs, the best one is kept (0 if not given)
+    double time_limit = 0.0; // Seconds for the whole run, 0 for no limit
+    optimizer::OBJECTIVE objective = optimizer::MAX_COVERAGE; // Criterion to select the best run
+    INITIALIZATION initialization = RANDOM_INIT; // Initial gateways of the attractor
+    FORCE_MODE force_mode = AGGREGATED_FORCE; // Force computation of the attractor
+    std::string checkpoint_filename; // Checkpoint written by the attractor
+    int checkpoint_interval = CHECKPOINT_INTERVAL; // Iterations between checkpoints
+    std::string resume_filename; // Checkpoint to continue the attractor from
+    int prune_loss = -1; // End devices the pruning of redundant gateways can lose, -1 for no pruning
+    terrain::GRID_LAYOUT grid_layout = terrain::ROW_MAJOR;
 
     global::PRINT_TYPE outputFormat = global::PLAIN_TEXT;
 
@@ -44,11 +61,155 @@ int main(int argc, char **argv) {
             if(i+1 < argc) {
                 const char* file = argv[i+1];
                 max_iterations = atoi(file);
+                if(max_iterations < 1)
+                    global::printHelp(MANUAL, "Error in argument -i (--iters). A positive integer number must be provided");
             }else{
                 global::printHelp(MANUAL, "Error in argument -i (--iters). An integer number must be provided");
             }
         }
 
+        if(strcmp(argv[i], "-a") == 0 || strcmp(argv[i], "--algorithm") == 0) {
+            if(i+1 < argc) {
+                algorithm = std::string(argv[i+1]);
+                if(optimizer::findAlgorithm(algorithm) == nullptr)
+                    global::printHelp(MANUAL, ("Error in argument -a (--algorithm). Supported algorithms: " + optimizer::algorithmNames()).c_str());
+            }else{
+                global::printHelp(MANUAL, "Error in argument -a (--algorithm). An algorithm name must be provided");
+            }
+        }
+
+        if(strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--coverage") == 0) {
+            if(i+1 < argc) {
+                coverage_filename = std::string(argv[i+1]);
+            }else{
+                global::printHelp(MANUAL, "Error in argument -c (--coverage). A filename must be provided");
+            }
+        }
+
+        if(strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "--starts") == 0) {
+            if(i+1 < argc) {
+                starts = atoi(argv[i+1]);
+                if(starts < 1)
+                    global::printHelp(MANUAL, "Error in argument -n (--starts). A positive integer number must be provided");
+            }else{
+                global::printHelp(MANUAL, "Error in argument -n (--starts). An integer number must be provided");
+            }
+        }
+
+        if(strcmp(argv[i], "--objective") == 0) {
+            if(i+1 < argc) {
+                const char* obj = argv[i+1];
+                if(strcmp(obj, "coverage") == 0) {
+                    objective = optimizer::MAX_COVERAGE;
+                } else if(strcmp(obj, "gateways") == 0) {
+                    objective = optimizer::MIN_GATEWAYS;
+                } else if(strcmp(obj, "distance") == 0) {
+                    objective = optimizer::MIN_DISTANCE;
+                } else {
+                    global::printHelp(MANUAL, "Error in argument --objective. Supported objectives: coverage, gateways, distance");
+                }
+            } else {
+                global::printHelp(MANUAL, "Error in argument --objective");
+            }
+        }
+
+        if(strcmp(argv[i], "--init") == 0) {
+            if(i+1 < argc) {
+                const char* init = argv[i+1];
+                if(strcmp(init, "random") == 0) {
+                    initialization = RANDOM_INIT;
+                } else if(strcmp(init, "kmeans") == 0) {
+                    initialization = KMEANS_INIT;
+                } else if(strcmp(init, "kmedoids") == 0) {
+                    initialization = KMEDOIDS_INIT;
+                } else {
+                    global::printHelp(MANUAL, "Error in argument --init. Supported initializations: random, kmeans, kmedoids");
+                }
+            } else {
+                global::printHelp(MANUAL, "Error in argument --init");
+            }
+        }
+
+        if(strcmp(argv[i], "--forces") == 0) {
+            if(i+1 < argc) {
+                const char* mode = argv[i+1];
+                if(strcmp(mode, "aggregated") == 0) {
+                    force_mode = AGGREGATED_FORCE;
+                } else if(strcmp(mode, "exact") == 0) {
+                    force_mode = EXACT_FORCE;
+                } else if(strcmp(mode, "blocked") == 0) {
+                    force_mode = BLOCKED_FORCE;
+                } else {
+                    global::printHelp(MANUAL, "Error in argument --forces. Supported modes: aggregated, exact, blocked");
+                }
+            } else {
+                global::printHelp(MANUAL, "Error in argument --forces");
+            }
+        }
+
+        if(strcmp(argv[i], "--time-limit") == 0) {
+            if(i+1 < argc) {
+                time_limit = atof(argv[i+1]);
+                if(time_limit <= 0.0)
+                    global::printHelp(MANUAL, "Error in argument --time-limit. A positive number of seconds must be provided");
+            }else{
+                global::printHelp(MANUAL, "Error in argument --time-limit. A number of seconds must be provided");
+            }
+        }
+
+        if(strcmp(argv[i], "--checkpoint") == 0) {
+            if(i+1 < argc) {
+                checkpoint_filename = std::string(argv[i+1]);
+            }else{
+                global::printHelp(MANUAL, "Error in argument --checkpoint. A filename must be provided");
+            }
+        }
+
+        if(strcmp(argv[i], "--checkpoint-interval") == 0) {
+            if(i+1 < argc) {
+                checkpoint_interval = atoi(argv[i+1]);
+                if(checkpoint_interval <= 0)
+                    global::printHelp(MANUAL, "Error in argument --checkpoint-interval. A positive number of iterations must be provided");
+            }else{
+                global::printHelp(MANUAL, "Error in argument --checkpoint-interval. A number of iterations must be provided");
+            }
+        }
+
+        if(strcmp(argv[i], "--resume") == 0) {
+            if(i+1 < argc) {
+                resume_filename = std::string(argv[i+1]);
+            }else{
+                global::printHelp(MANUAL, "Error in argument --resume. A filename must be provided");
+            }
+        }
+
+        if(strcmp(argv[i], "--prune") == 0) {
+            if(i+1 < argc) {
+                prune_loss = atoi(argv[i+1]);
+                if(prune_loss < 0)
+                    global::printHelp(MANUAL, "Error in argument --prune. A non-negative number of end devices must be provided");
+            }else{
+                global::printHelp(MANUAL, "Error in argument --prune. A number of end devices must be provided");
+            }
+        }
+
+        if(strcmp(argv[i], "--grid-tiles") == 0) {
+            grid_layout = terrain::Z_ORDER_TILES;
+        }
+
+        if(strcmp(argv[i], "--seed") == 0) {
+            if(i+1 < argc) {
+                char* end = nullptr;
+                errno = 0;
+                const unsigned long long value = std::strtoull(argv[i+1], &end, 10);
+                if(end == argv[i+1] || *end != '\0' || errno == ERANGE || argv[i+1][0] == '-')
+                    global::printHelp(MANUAL, "Error in argument --seed. A non-negative integer number must be provided");
+                rng::setSeed(value);
+            }else{
+                global::printHelp(MANUAL, "Error in argument --seed. An integer number must be provided");
+            }
+        }
+
         if(strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--output") == 0) {
             if(i+1 < argc) {
                 const char* fmt = argv[i+1];
@@ -79,11 +240,48 @@ int main(int argc, char **argv) {
         global::printHelp(MANUAL, "Error in argument -f (--em_file). A filename must be provided.");
     }
     
+    global::dbg << "Random seed: " << rng::getSeed() << std::endl;
+
     auto grid = terrain::ElevationGrid::fromCSV(em_filename);
+    grid.setLayout(grid_layout);
     auto network = network::Network::fromGeoJSON(nw_filename);
     network.setElevationGrid(grid);
 
-    AttractorOptimizer(network).optimize(max_iterations);
+    if(starts > 0 && algorithm != "attractor" && algorithm != "multistart")
+        global::printHelp(MANUAL, "Error in argument -n (--starts). Only the \"attractor\" and \"multistart\" algorithms run several starts");
+
+    if(!resume_filename.empty() && (algorithm != "attractor" || starts > 1))
+        global::printHelp(MANUAL, "Error in argument --resume. Only single runs of the attractor can be resumed");
+
+    const auto deadline = time_limit > 0.0 ? 
+        start_time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(time_limit)) :
+        std::chrono::steady_clock::time_point::max();
+
+    const std::size_t input_gateways = network.getGatewayCount();
+
+    if(algorithm == "attractor" && starts > 1)
+        algorithm = "multistart";
+
+    optimizer::Parameters params;
+    params.iterations = max_iterations;
+    params.deadline = deadline;
+    params.coverage_file = coverage_filename;
+    params.starts = starts;
+    params.objective = objective;
+    params.initialization = initialization;
+    params.force_mode = force_mode;
+    params.checkpoint_file = checkpoint_filename;
+    params.checkpoint_interval = checkpoint_interval;
+    params.resume_file = resume_filename;
+
+    const optimizer::Result result = optimizer::run(algorithm, network, params);
+    global::dbg << "Result: " << result.toJSON().dump() << std::endl;
+
+    if(prune_loss >= 0) { // The gateways of the input are kept
+        PruningOptimizer pruning(network, input_gateways);
+        pruning.setDeadline(deadline);
+        pruning.optimize(prune_loss);
+    }
 
     network.print(outputFormat);
 
@@ -0,0 +1,169 @@
+#include "../include/swarm_optimizer.hpp"
+#include <algorithm>
+#include <limits>
+
+SwarmOptimizer::Fitness SwarmOptimizer::evaluate(const std::vector<double>& position, std::vector<double>& dist) const {
+    const auto& grid = network.getElevationGrid();
+    const auto& eds = network.getEndDevices();
+
+    std::copy(fixed_dist.begin(), fixed_dist.end(), dist.begin());
+
+    Fitness fitness;
+    for(std::size_t g = 0; g < SWARM_MAX_GATEWAYS; g++) {
+        const double* slot = position.data() + g * DIMS;
+        if(slot[2] <= 0.0) continue; // Inactive
+        terrain::LatLngAlt location = {slot[0], slot[1], SWARM_GATEWAY_HEIGHT};
+        // Particles move freely, gateways are placed at the closest permitted position (inactive if there is none)
+        if(!network.getSiteConstraints().snap(location)) continue;
+        fitness.gateways++;
+        const projection::Point point = network.getFrame().project(location);
+        for(std::size_t e = 0; e < eds.size(); e++) {
+            // Same criteria as Network::connect(), range check first and line of sight only if it improves
+            if(projection::squaredDistance(point, ed_points[e]) >= network::MAX_RANGE_SQUARED) continue;
+            const double d = grid.haversineDistance(location, eds[e].location);
+            if(d < dist[e] && grid.lineOfSight(location, eds[e].location))
+                dist[e] = d;
+        }
+    }
+
+    fitness.cost = fitness.gateways;
+    for(double d : dist) {
+        fitness.cost += optimizer::deviceCost(d);
+        if(!std::isinf(d)) {
+            fitness.connected++;
+            fitness.distance += d;
+        }
+    }
+    return fitness;
+};
+
+void SwarmOptimizer::optimize(unsigned int maxIterations) {
+
+    startTelemetry();
+    stop_reason = optimizer::NOT_STOPPED;
+
+    const auto& eds = network.getEndDevices();
+    const std::size_t num_devices = eds.size();
+    const std::size_t dims = SWARM_MAX_GATEWAYS * DIMS;
+
+    if(num_devices == 0 || swarm.empty()) {
+        network.connect();
+        return;
+    }
+
+    fixed_dist = optimizer::fixedDistances(network);
+    ed_points.resize(num_devices);
+    for(std::size_t e = 0; e < num_devices; e++)
+        ed_points[e] = network.getFrame().project(eds[e].location);
+    const std::size_t fixed_gateways = network.getGatewayCount();
+
+    const std::vector<double> bbox = network.getBoundingBox();
+    lower.assign(dims, 0.0);
+    upper.assign(dims, 0.0);
+    max_velocity.assign(dims, 0.0);
+    for(std::size_t g = 0; g < SWARM_MAX_GATEWAYS; g++) {
+        lower[g * DIMS] = bbox[1]; upper[g * DIMS] = bbox[3];
+        lower[g * DIMS + 1] = bbox[0]; upper[g * DIMS + 1] = bbox[2];
+        lower[g * DIMS + 2] = -1.0; upper[g * DIMS + 2] = 1.0;
+    }
+    for(std::size_t d = 0; d < dims; d++)
+        max_velocity[d] = SWARM_MAX_VELOCITY * (upper[d] - lower[d]);
+
+    // Buffers are allocated once, gateways start on random end devices
+    for(std::size_t p = 0; p < swarm.size(); p++) {
+        Particle& particle = swarm[p];
+        particle.gen = rng::stream(p);
+        particle.position.assign(dims, 0.0);
+        particle.velocity.assign(dims, 0.0);
+        particle.dist.assign(num_devices, 0.0);
+
+        std::uniform_int_distribution<std::size_t> device(0, num_devices - 1);
+        std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+        for(std::size_t g = 0; g < SWARM_MAX_GATEWAYS; g++) {
+            const terrain::LatLngAlt& location = eds[device(particle.gen)].location;
+            particle.position[g * DIMS] = location.lat;
+            particle.position[g * DIMS + 1] = location.lng;
+            particle.position[g * DIMS + 2] = uniform(particle.gen);
+        }
+        for(std::size_t d = 0; d < dims; d++)
+            particle.velocity[d] = 0.1 * uniform(particle.gen) * max_velocity[d];
+        particle.best_position = particle.position;
+    }
+
+    std::vector<double> global_position(dims);
+    Fitness global_fitness;
+    global_fitness.cost = std::numeric_limits<double>::infinity();
+
+    unsigned int iter = 0;
+    for(; iter <= maxIterations; iter++) {
+        if(iter > 0 && deadlineReached()) { // The initial swarm is always evaluated
+            global::dbg << "Time limit reached at iteration " << iter << std::endl;
+            stop_reason = optimizer::TIME_LIMIT;
+            break;
+        }
+
+        #pragma omp parallel for schedule(dynamic) // parallelize over particles
+        for(std::size_t p = 0; p < swarm.size(); p++) {
+            Particle& particle = swarm[p];
+            if(iter > 0) { // Move towards the particle best and the swarm best of the previous iteration
+                std::uniform_real_distribution<double> uniform(0.0, 1.0);
+                for(std::size_t d = 0; d < dims; d++) {
+                    double v = SWARM_INERTIA * particle.velocity[d]
+                             + SWARM_COGNITIVE * uniform(particle.gen) * (particle.best_position[d] - particle.position[d])
+                             + SWARM_SOCIAL * uniform(particle.gen) * (global_position[d] - particle.position[d]);
+                    v = std::clamp(v, -max_velocity[d], max_velocity[d]);
+                    particle.velocity[d] = v;
+                    particle.position[d] = std::clamp(particle.position[d] + v, lower[d], upper[d]);
+                }
+            }
+            particle.fitness = evaluate(particle.position, particle.dist);
+            if(iter == 0 || particle.fitness.cost < particle.best_fitness.cost) {
+                particle.best_fitness = particle.fitness;
+                std::copy(particle.position.begin(), particle.position.end(), particle.best_position.begin());
+            }
+        }
+        evaluations += swarm.size();
+
+        // Lowest index wins ties, so the swarm best does not depend on the schedule
+        for(const Particle& particle : swarm) {
+            if(particle.best_fitness.cost < global_fitness.cost) {
+                global_fitness = particle.best_fitness;
+                std::copy(particle.best_position.begin(), particle.best_position.end(), global_position.begin());
+            }
+        }
+
+        record(iter, {global_fitness.connected, fixed_gateways + global_fitness.gateways, global_fitness.distance});
+
+        global::dbg << "Iteration " << iter << "/" << maxIterations << ": best cost " << global_fitness.cost
+                    << " (" << global_fitness.gateways << " gateways, " << global_fitness.connected << " connected)" << std::endl;
+    }
+
+    if(stop_reason == optimizer::NOT_STOPPED)
+        stop_reason = optimizer::ITERATION_LIMIT;
+
+    for(std::size_t g = 0; g < SWARM_MAX_GATEWAYS; g++) {
+        const double* slot = global_position.data() + g * DIMS;
+        if(slot[2] > 0.0) {
+            terrain::LatLngAlt location = {slot[0], slot[1], SWARM_GATEWAY_HEIGHT};
+            if(network.getSiteConstraints().snap(location)) {
+                network.addGateway(location);
+            } else {
+                snap_failures++;
+            }
+        }
+    }
+    network.connect();
+    record(iter, optimizer::Score::of(network));
+
+    network.setProperty("optimization", {
+        {"algorithm", "swarm"},
+        {"iterations", iter > 0 ? iter - 1 : 0},
+        {"particles", swarm.size()},
+        {"evaluations", evaluations},
+        {"gateways_added", global_fitness.gateways},
+        {"snap_failures", snap_failures},
+        {"cost", global_fitness.cost},
+        {"stop_reason", optimizer::stopReasonName(stop_reason)},
+        {"elapsed_ms", getElapsed()}
+    });
+};
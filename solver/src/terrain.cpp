@@ -1,9 +1,12 @@
 #include "../include/terrain.hpp"
+#include "../include/curves.hpp"
 #include <algorithm>
 #include <cmath>
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
+#include <limits>
+#include <cstring>
 
 namespace terrain {
 
@@ -29,7 +32,7 @@ ElevationGrid::ElevationGrid(const std::vector<double>& lats_raw, const std::vec
     }
 
     // Initialize grid with NaNs (useful when there are gaps)
-    elevationGrid.assign(latitudes.size(), std::vector<double>(longitudes.size(), std::numeric_limits<double>::quiet_NaN()));
+    elevations.assign(latitudes.size() * longitudes.size(), std::numeric_limits<double>::quiet_NaN());
 
     // Fill grid: for each raw point, find its (i,j) on the unique axes
     for (size_t k = 0; k < alts_raw.size(); ++k) {
@@ -47,8 +50,18 @@ ElevationGrid::ElevationGrid(const std::vector<double>& lats_raw, const std::vec
         j = clampIndexForCell(int(longitudes.size()), (j > 0 ? j - 1 : j));
         if (i < 0 || j < 0) continue; // can't place (too small grid), but we checked earlier
 
-        elevationGrid[i][j] = alts_raw[k];
+        elevations[offset(i, j)] = alts_raw[k];
     }
+
+    // FNV-1a over 64 bit words, row-major so it does not depend on the layout
+    checksum = 14695981039346656037ull;
+    auto mix = [this](std::uint64_t word) { checksum = (checksum ^ word) * 1099511628211ull; };
+    auto mixDouble = [&mix](double value) { std::uint64_t bits; std::memcpy(&bits, &value, sizeof(bits)); mix(bits); };
+    mix(latitudes.size());
+    mix(longitudes.size());
+    for (double lat : latitudes) mixDouble(lat);
+    for (double lng : longitudes) mixDouble(lng);
+    for (double alt : elevations) mixDouble(alt); // Row-major at construction
 };
 
 ElevationGrid ElevationGrid::fromCSV(const std::string& filepath) {
@@ -112,10 +125,10 @@ double ElevationGrid::bilinearInterpolation(double lat, double lng) const {
     const double x1 = longitudes[j],   x2 = longitudes[j+1];
 
     // Grid cell values
-    const double Q11 = elevationGrid[i][j];
-    const double Q21 = elevationGrid[i][j+1];
-    const double Q12 = elevationGrid[i+1][j];
-    const double Q22 = elevationGrid[i+1][j+1];
+    const double Q11 = at(i, j);
+    const double Q21 = at(i, j+1);
+    const double Q12 = at(i+1, j);
+    const double Q22 = at(i+1, j+1);
 
     // If any is NaN (hole), you could fallback to nearest neighbor:
     auto isnan = [](double v){ return std::isnan(v); };
@@ -125,7 +138,7 @@ double ElevationGrid::bilinearInterpolation(double lat, double lng) const {
         double wx = (std::fabs(lng - x1) <= std::fabs(x2 - lng)) ? x1 : x2;
         int ii = (wy == y1 ? i : i+1);
         int jj = (wx == x1 ? j : j+1);
-        return elevationGrid[ii][jj];
+        return at(ii, jj);
     }
 
     // Bilinear
@@ -199,6 +212,51 @@ bool ElevationGrid::lineOfSight(const LatLngAlt pos1, const LatLngAlt pos2, bool
     return lineOfSight(pos1.lat, pos1.lng, pos2.lat, pos2.lng, pos1.alt, pos2.alt, fesnelClearance);
 };
 
+std::vector<LinkResult> ElevationGrid::lineOfSight(double lat1, double lng1,
+                                                   double lat2, double lng2,
+                                                   const std::vector<LinkScenario>& scenarios) const {
+    std::vector<double> profile(SAMPLES_STEPS + 1);
+    for (int k = 0; k <= SAMPLES_STEPS; ++k) {
+        const double t = double(k) / SAMPLES_STEPS;
+        profile[k] = bilinearInterpolation(lat1 + t * (lat2 - lat1), lng1 + t * (lng2 - lng1));
+    }
+    return lineOfSight(profile, equirectangularDistance(lat1, lng1, lat2, lng2), scenarios);
+};
+
+std::vector<LinkResult> ElevationGrid::lineOfSight(const std::vector<double>& profile,
+                                                   double pathLength,
+                                                   const std::vector<LinkScenario>& scenarios) {
+    std::vector<LinkResult> results(scenarios.size());
+    const int steps = static_cast<int>(profile.size()) - 1;
+    if (steps < 1) return results;
+
+    // Radius of the first Fresnel zone at each sample for a unit wavelength, shared by every scenario
+    std::vector<double> unit_radius(steps, 0.0);
+    for (int k = 1; k < steps; ++k) {
+        const double t  = double(k) / steps;
+        const double d1 = pathLength * t;
+        const double d2 = pathLength * (1.0 - t);
+        unit_radius[k] = d1 + d2 > 0.0 ? std::sqrt(d1 * d2 / (d1 + d2)) : 0.0;
+    }
+
+    for (size_t s = 0; s < scenarios.size(); ++s) {
+        const LinkScenario& scenario = scenarios[s];
+        const double elev1 = profile.front() + scenario.observerHeight;
+        const double elev2 = profile.back() + scenario.targetHeight;
+        const double scale = scenario.wavelength > 0.0 ? scenario.clearanceFactor * std::sqrt(scenario.wavelength) : 0.0;
+
+        double margin = std::numeric_limits<double>::infinity();
+        for (int k = 1; k < steps; ++k) { // Same samples and criterion as lineOfSight()
+            const double t   = double(k) / steps;
+            const double los = elev1 + t * (elev2 - elev1);
+            margin = std::min(margin, los - scale * unit_radius[k] - profile[k]);
+        }
+        results[s].clear = !(margin < 0.0);
+        results[s].margin = margin;
+    }
+    return results;
+};
+
 double ElevationGrid::haversineDistance(double lat1, double lng1, double lat2, double lng2) const {
     const double dlat = global::toRadians(lat2 - lat1);
     const double dlon = global::toRadians(lng2 - lng1);
@@ -263,10 +321,68 @@ double ElevationGrid::equirectangularDistance(const LatLngAlt pos1, const LatLng
     return equirectangularDistance(pos1.lat, pos1.lng, pos2.lat, pos2.lng);
 };
 
+void ElevationGrid::setLayout(GRID_LAYOUT newLayout) {
+    if(newLayout == layout) return;
+    const std::size_t rows = latitudes.size(), cols = longitudes.size();
+    std::vector<double> values(elevations.size());
+    for(std::size_t i = 0; i < rows; i++) // Row-major copy
+        for(std::size_t j = 0; j < cols; j++)
+            values[i * cols + j] = at(i, j);
+
+    layout = newLayout;
+    if(layout == ROW_MAJOR) {
+        tile_slot.clear();
+        tile_cols = 0;
+        elevations = std::move(values);
+        return;
+    }
+
+    // Tiles sorted by the Morton key of their (column, row), the last ones are padded
+    const std::size_t side = std::size_t(1) << GRID_TILE_BITS;
+    const std::size_t tile_rows = (rows + side - 1) / side;
+    tile_cols = (cols + side - 1) / side;
+    std::vector<std::uint32_t> tiles(tile_rows * tile_cols);
+    for(std::size_t t = 0; t < tiles.size(); t++) tiles[t] = t;
+    std::sort(tiles.begin(), tiles.end(), [&](std::uint32_t a, std::uint32_t b) {
+        return curves::mortonKey(a % tile_cols, a / tile_cols) < curves::mortonKey(b % tile_cols, b / tile_cols);
+    });
+    tile_slot.assign(tiles.size(), 0);
+    for(std::size_t s = 0; s < tiles.size(); s++) tile_slot[tiles[s]] = s;
+
+    elevations.assign(tiles.size() * side * side, std::numeric_limits<double>::quiet_NaN());
+    for(std::size_t i = 0; i < rows; i++)
+        for(std::size_t j = 0; j < cols; j++)
+            elevations[offset(i, j)] = values[i * cols + j];
+};
+
+std::array<std::size_t, 4> ElevationGrid::interpolationOffsets(double lat, double lng) const {
+    const int i = findIndex(latitudes, lat);
+    const int j = findIndex(longitudes, lng);
+    return {offset(i, j), offset(i, j+1), offset(i+1, j), offset(i+1, j+1)};
+};
+
+std::uint64_t ElevationGrid::cellKey(double lat, double lng, unsigned int cells) const {
+    const std::uint64_t i = findIndex(latitudes, lat) / cells;
+    const std::uint64_t j = findIndex(longitudes, lng) / cells;
+    const std::uint64_t block_cols = (longitudes.size() - 2) / cells + 1;
+    return i * block_cols + j;
+};
+
+LatLngAlt ElevationGrid::cellCenter(const LatLngAlt& pos, unsigned int cells) const {
+    // Corner nodes of the block, the last block of each axis may be smaller
+    const std::size_t i0 = findIndex(latitudes, pos.lat) / cells * cells;
+    const std::size_t j0 = findIndex(longitudes, pos.lng) / cells * cells;
+    const std::size_t i1 = std::min<std::size_t>(i0 + cells, latitudes.size() - 1);
+    const std::size_t j1 = std::min<std::size_t>(j0 + cells, longitudes.size() - 1);
+    return {(latitudes[i0] + latitudes[i1]) / 2, (longitudes[j0] + longitudes[j1]) / 2, pos.alt};
+};
+
 double ElevationGrid::getMaxAltitude() const {
     double maxAlt = -DBL_MAX;
-    for(const auto& row : elevationGrid) {
-        double rowMax = *std::max_element(row.begin(), row.end());
+    for(std::size_t i = 0; i < latitudes.size(); i++) {
+        double rowMax = at(i, 0); // First largest of the row, as std::max_element
+        for(std::size_t j = 1; j < longitudes.size(); j++)
+            if(rowMax < at(i, j)) rowMax = at(i, j);
         if(rowMax > maxAlt) {
             maxAlt = rowMax;
         }
@@ -276,8 +392,10 @@ double ElevationGrid::getMaxAltitude() const {
 
 double ElevationGrid::getMinAltitude() const {
     double minAlt = DBL_MAX;
-    for(const auto& row : elevationGrid) {
-        double rowMin = *std::min_element(row.begin(), row.end());
+    for(std::size_t i = 0; i < latitudes.size(); i++) {
+        double rowMin = at(i, 0);
+        for(std::size_t j = 1; j < longitudes.size(); j++)
+            if(at(i, j) < rowMin) rowMin = at(i, j);
         if(rowMin < minAlt) {
             minAlt = rowMin;
         }
@@ -303,5 +421,165 @@ LatLngAlt getCentroid(const std::vector<LatLngAlt>& points) {
     };
 };
 
+namespace {
+
+// Per-position terms of the batch kernels, as arrays so the loops over pairs vectorize
+struct Terms {
+    std::vector<double> a, b, c, d;
+};
+
+// Points of the unit sphere for the haversine (chord) kernel
+Terms unitVectors(const std::vector<LatLngAlt>& positions) {
+    const std::size_t n = positions.size();
+    Terms t{std::vector<double>(n), std::vector<double>(n), std::vector<double>(n), {}};
+    for(std::size_t i = 0; i < n; i++) {
+        const double phi = global::toRadians(positions[i].lat);
+        const double lambda = global::toRadians(positions[i].lng);
+        t.a[i] = std::cos(phi) * std::cos(lambda);
+        t.b[i] = std::cos(phi) * std::sin(lambda);
+        t.c[i] = std::sin(phi);
+    }
+    return t;
+};
+
+// Radians and sine and cosine of half the latitude for the equirectangular kernel
+Terms halfLatitudes(const std::vector<LatLngAlt>& positions) {
+    const std::size_t n = positions.size();
+    Terms t{std::vector<double>(n), std::vector<double>(n), std::vector<double>(n), std::vector<double>(n)};
+    for(std::size_t i = 0; i < n; i++) {
+        t.a[i] = global::toRadians(positions[i].lat);
+        t.b[i] = global::toRadians(positions[i].lng);
+        t.c[i] = std::sin(t.a[i] / 2);
+        t.d[i] = std::cos(t.a[i] / 2);
+    }
+    return t;
+};
+
+// ECEF coordinates with the altitudes as heights, as in straightLineDistance()
+Terms earthCentered(const std::vector<LatLngAlt>& positions) {
+    const std::size_t n = positions.size();
+    Terms t{std::vector<double>(n), std::vector<double>(n), std::vector<double>(n), {}};
+    for(std::size_t i = 0; i < n; i++) {
+        const Vec3 p = toECEF(positions[i].lat, positions[i].lng, positions[i].alt);
+        t.a[i] = p.x;
+        t.b[i] = p.y;
+        t.c[i] = p.z;
+    }
+    return t;
+};
+
+inline double chordHalf(const Terms& u, std::size_t i, const Terms& v, std::size_t j) {
+    const double dx = v.a[j] - u.a[i], dy = v.b[j] - u.b[i], dz = v.c[j] - u.c[i];
+    return 0.5 * std::sqrt(dx*dx + dy*dy + dz*dz);
+};
+
+// Arcsine by its Taylor series up to x^9, the first omitted term is 63/2816 x^11 (relative error below 3e-15 at 0.05)
+inline double asinSeries(double x) {
+    const double x2 = x * x;
+    return x * (1.0 + x2 * (1.0/6.0 + x2 * (3.0/40.0 + x2 * (5.0/112.0 + x2 * (35.0/1152.0)))));
+};
+
+// Kernels of one pair, as function objects so each instantiation of indexed() and matrix() inlines its kernel in the simd loop
+struct HaversineKernel {
+    inline double operator()(const Terms& u, std::size_t i, const Terms& v, std::size_t j) const {
+        return 2.0 * EARTH_RADIUS * asinSeries(chordHalf(u, i, v, j));
+    };
+};
+
+// Distances over ASIN_SERIES_LIMIT are recomputed with std::asin (rarely any in a network)
+struct HaversineExact {
+    inline double operator()(const Terms& u, std::size_t i, const Terms& v, std::size_t j) const {
+        return 2.0 * EARTH_RADIUS * std::asin(std::min(1.0, chordHalf(u, i, v, j)));
+    };
+};
+
+struct EquirectangularKernel {
+    inline double operator()(const Terms& u, std::size_t i, const Terms& v, std::size_t j) const {
+        const double cos_mean = u.d[i] * v.d[j] - u.c[i] * v.c[j]; // cos(lat1/2 + lat2/2)
+        const double x = (v.b[j] - u.b[i]) * cos_mean;
+        const double y = v.a[j] - u.a[i];
+        return EARTH_RADIUS * std::sqrt(x*x + y*y);
+    };
+};
+
+struct SlantKernel {
+    inline double operator()(const Terms& u, std::size_t i, const Terms& v, std::size_t j) const {
+        const double dx = v.a[j] - u.a[i], dy = v.b[j] - u.b[i], dz = v.c[j] - u.c[i];
+        return std::sqrt(dx*dx + dy*dy + dz*dz);
+    };
+};
+
+// Limit of the series in meters, with margin for the rounding of the chord
+constexpr double SERIES_MAX_DISTANCE = 2.0 * EARTH_RADIUS * ASIN_SERIES_LIMIT * 0.999;
+
+template <typename Kernel>
+void indexed(const Terms& from, const Terms& to, const std::vector<int>& index, std::vector<double>& out, const Kernel& kernel) {
+    const std::size_t n = index.size();
+    out.assign(n, 0.0);
+    #pragma omp simd
+    for(std::size_t i = 0; i < n; i++) {
+        const std::size_t j = index[i] < 0 ? 0 : index[i];
+        const double d = kernel(from, i, to, j);
+        out[i] = index[i] < 0 ? 0.0 : d;
+    }
+};
+
+template <typename Kernel>
+void matrix(const Terms& rows, std::size_t num_rows, const Terms& cols, std::size_t num_cols, std::vector<double>& out, const Kernel& kernel) {
+    out.resize(num_rows * num_cols);
+    #pragma omp parallel for schedule(static)
+    for(int r = 0; r < static_cast<int>(num_rows); r++) {
+        double* row = out.data() + r * num_cols;
+        #pragma omp simd
+        for(std::size_t c = 0; c < num_cols; c++)
+            row[c] = kernel(rows, r, cols, c);
+    }
+};
+
+} // namespace
+
+void haversineDistances(const std::vector<LatLngAlt>& from, const std::vector<LatLngAlt>& to, const std::vector<int>& index, std::vector<double>& out) {
+    if(to.empty()) { 
+        out.assign(index.size(), 0.0);
+        return;
+    }
+    const Terms u = unitVectors(from), v = unitVectors(to);
+    indexed(u, v, index, out, HaversineKernel{});
+    for(std::size_t i = 0; i < out.size(); i++) {
+        if(out[i] > SERIES_MAX_DISTANCE) out[i] = HaversineExact{}(u, i, v, index[i]);
+    }
+};
+
+void equirectangularDistances(const std::vector<LatLngAlt>& from, const std::vector<LatLngAlt>& to, const std::vector<int>& index, std::vector<double>& out) {
+    if(to.empty()) {
+        out.assign(index.size(), 0.0);
+        return;
+    }
+    indexed(halfLatitudes(from), halfLatitudes(to), index, out, EquirectangularKernel{});
+};
+
+void slantRanges(const std::vector<LatLngAlt>& from, const std::vector<LatLngAlt>& to, const std::vector<int>& index, std::vector<double>& out) {
+    if(to.empty()) {
+        out.assign(index.size(), 0.0);
+        return;
+    }
+    indexed(earthCentered(from), earthCentered(to), index, out, SlantKernel{});
+};
+
+void haversineMatrix(const std::vector<LatLngAlt>& rows, const std::vector<LatLngAlt>& cols, std::vector<double>& out) {
+    const Terms u = unitVectors(rows), v = unitVectors(cols);
+    matrix(u, rows.size(), v, cols.size(), out, HaversineKernel{});
+    for(std::size_t k = 0; k < out.size(); k++) {
+        if(out[k] > SERIES_MAX_DISTANCE) out[k] = HaversineExact{}(u, k / cols.size(), v, k % cols.size());
+    }
+};
+
+void equirectangularMatrix(const std::vector<LatLngAlt>& rows, const std::vector<LatLngAlt>& cols, std::vector<double>& out) {
+    matrix(halfLatitudes(rows), rows.size(), halfLatitudes(cols), cols.size(), out, EquirectangularKernel{});
+};
+
+void slantRangeMatrix(const std::vector<LatLngAlt>& rows, const std::vector<LatLngAlt>& cols, std::vector<double>& out) {
+    matrix(earthCentered(rows), rows.size(), earthCentered(cols), cols.size(), out, SlantKernel{});
+};
 
-} // namespace terrain
\ No newline at end of file
+} // namespace terrain
@@ -0,0 +1,97 @@
+#include "../include/visibility.hpp"
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+#include <stdexcept>
+
+namespace visibility {
+
+nlohmann::json Agreement::toJSON() const {
+    return {
+        {"cells", cells},
+        {"links", links},
+        {"cell_pairs", cell_pairs},
+        {"samples", samples},
+        {"clear", clear},
+        {"false_clear", false_clear},
+        {"false_blocked", false_blocked},
+        {"disagreement_rate", disagreementRate()}
+    };
+};
+
+CellLineOfSight::CellLineOfSight(const terrain::ElevationGrid& grid, unsigned int cells) : grid(&grid), cells(cells) {
+    if(cells < 1)
+        throw std::invalid_argument("Line of sight cells must be at least 1");
+};
+
+void CellLineOfSight::groupLinks(const std::vector<terrain::LatLngAlt>& from, const std::vector<terrain::LatLngAlt>& to, const std::vector<Link>& links,
+                                 std::vector<std::uint32_t>& order, std::vector<std::size_t>& runs) const {
+    using Key = std::tuple<std::uint64_t, double, std::uint64_t, double>; // Cell and height of both ends
+    std::vector<std::uint64_t> from_cell(from.size()), to_cell(to.size());
+    for(std::size_t i = 0; i < from.size(); i++) from_cell[i] = grid->cellKey(from[i].lat, from[i].lng, cells);
+    for(std::size_t i = 0; i < to.size(); i++) to_cell[i] = grid->cellKey(to[i].lat, to[i].lng, cells);
+
+    std::vector<Key> keys(links.size());
+    for(std::size_t l = 0; l < links.size(); l++)
+        keys[l] = Key(from_cell[links[l].from], from[links[l].from].alt, to_cell[links[l].to], to[links[l].to].alt);
+    order.resize(links.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) { return keys[a] < keys[b]; });
+
+    runs.clear();
+    for(std::size_t k = 0; k < order.size(); k++) {
+        if(k == 0 || keys[order[k]] != keys[order[k-1]])
+            runs.push_back(k);
+    }
+    runs.push_back(order.size());
+};
+
+std::vector<char> CellLineOfSight::lineOfSight(const std::vector<terrain::LatLngAlt>& from, const std::vector<terrain::LatLngAlt>& to, const std::vector<Link>& links) const {
+    std::vector<std::uint32_t> order;
+    std::vector<std::size_t> runs;
+    groupLinks(from, to, links, order, runs);
+
+    std::vector<char> clear(links.size(), 0);
+    #pragma omp parallel for schedule(dynamic)
+    for(int r = 0; r < static_cast<int>(runs.size()) - 1; r++) {
+        const Link& link = links[order[runs[r]]]; // Any link of the run, all of them snap to the same positions
+        const char result = lineOfSight(from[link.from], to[link.to]) ? 1 : 0;
+        for(std::size_t k = runs[r]; k < runs[r+1]; k++)
+            clear[order[k]] = result;
+    }
+    return clear;
+};
+
+Agreement CellLineOfSight::agreement(const std::vector<terrain::LatLngAlt>& from, const std::vector<terrain::LatLngAlt>& to, const std::vector<Link>& links) const {
+    Agreement report;
+    report.cells = cells;
+    report.links = links.size();
+    std::vector<std::uint32_t> order;
+    std::vector<std::size_t> runs;
+    groupLinks(from, to, links, order, runs);
+    report.cell_pairs = runs.size() - 1;
+
+    std::vector<Link> sample;
+    const std::size_t stride = std::max<std::size_t>(1, (links.size() + LOS_AGREEMENT_SAMPLES - 1) / LOS_AGREEMENT_SAMPLES);
+    for(std::size_t l = 0; l < links.size(); l += stride)
+        sample.push_back(links[l]);
+    report.samples = sample.size();
+
+    std::size_t clear = 0, false_clear = 0, false_blocked = 0;
+    #pragma omp parallel for schedule(dynamic) reduction(+:clear, false_clear, false_blocked)
+    for(int s = 0; s < static_cast<int>(sample.size()); s++) {
+        const terrain::LatLngAlt& a = from[sample[s].from];
+        const terrain::LatLngAlt& b = to[sample[s].to];
+        const bool exact = grid->lineOfSight(a, b);
+        const bool approximate = lineOfSight(a, b);
+        if(exact) clear++;
+        if(approximate && !exact) false_clear++;
+        if(!approximate && exact) false_blocked++;
+    }
+    report.clear = clear;
+    report.false_clear = false_clear;
+    report.false_blocked = false_blocked;
+    return report;
+};
+
+} // namespace visibility
@@ -0,0 +1,307 @@
+#include "../include/zones.hpp"
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+namespace zones {
+
+namespace {
+
+// Twice the signed area of the triangle (a, b, p), positive if p is left of a -> b
+inline double orient(double ax, double ay, double bx, double by, double px, double py) {
+    return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+}
+
+// Segment p -> q crosses segment a -> b (touching counts on one side only, so crossings add up consistently)
+inline bool crosses(double ax, double ay, double bx, double by, double px, double py, double qx, double qy) {
+    if((orient(ax, ay, bx, by, px, py) > 0.0) == (orient(ax, ay, bx, by, qx, qy) > 0.0)) return false;
+    return (orient(px, py, qx, qy, ax, ay) > 0.0) != (orient(px, py, qx, qy, bx, by) > 0.0);
+}
+
+// Segment a -> b may intersect the rectangle: its corners are not all on the same side of the line
+inline bool touchesBox(double ax, double ay, double bx, double by, double x0, double y0, double x1, double y1) {
+    const double s[4] = {
+        orient(ax, ay, bx, by, x0, y0), orient(ax, ay, bx, by, x1, y0),
+        orient(ax, ay, bx, by, x0, y1), orient(ax, ay, bx, by, x1, y1)
+    };
+    const bool any_left = s[0] >= 0.0 || s[1] >= 0.0 || s[2] >= 0.0 || s[3] >= 0.0;
+    const bool any_right = s[0] <= 0.0 || s[1] <= 0.0 || s[2] <= 0.0 || s[3] <= 0.0;
+    return any_left && any_right;
+}
+
+inline std::size_t cellIndex(double v, double min_v, double step, std::size_t count) {
+    if(step <= 0.0) return 0;
+    const double i = std::floor((v - min_v) / step);
+    return static_cast<std::size_t>(std::clamp(i, 0.0, double(count - 1)));
+}
+
+// Flattens the lists of each cell into offsets and entries
+void compress(const std::vector<std::vector<std::uint32_t>>& lists, std::vector<std::uint32_t>& start, std::vector<std::uint32_t>& entries) {
+    start.assign(lists.size() + 1, 0);
+    for(std::size_t i = 0; i < lists.size(); i++)
+        start[i + 1] = start[i] + lists[i].size();
+    entries.clear();
+    entries.reserve(start.back());
+    for(const auto& list : lists)
+        entries.insert(entries.end(), list.begin(), list.end());
+}
+
+} // namespace
+
+ZoneIndex::ZoneIndex(const std::vector<geojson::Polygon>& polygons) {
+    std::vector<std::size_t> polygon_start; // Edges of polygon p are in [polygon_start[p], polygon_start[p + 1])
+    for(std::size_t p = 0; p < polygons.size(); p++) {
+        polygon_start.push_back(edges.size());
+        for(const auto& ring : polygons[p]) {
+            for(std::size_t i = 0; i < ring.size(); i++) {
+                const auto& a = ring[i];
+                const auto& b = ring[(i + 1) % ring.size()]; // Closes the ring if the last position is not the first one
+                if(a.size() < 2 || b.size() < 2)
+                    throw std::runtime_error("Invalid polygon: positions must have at least [lon, lat]");
+                if(a[0] == b[0] && a[1] == b[1]) continue;
+                edges.push_back({a[0], a[1], b[0], b[1], static_cast<std::uint32_t>(p)});
+            }
+        }
+    }
+    polygon_start.push_back(edges.size());
+    if(edges.empty())
+        return;
+    num_polygons = polygons.size();
+
+    min_x = max_x = edges[0].x0;
+    min_y = max_y = edges[0].y0;
+    for(const auto& e : edges) {
+        min_x = std::min({min_x, e.x0, e.x1});
+        max_x = std::max({max_x, e.x0, e.x1});
+        min_y = std::min({min_y, e.y0, e.y1});
+        max_y = std::max({max_y, e.y0, e.y1});
+    }
+
+    // Roughly square cells (in meters), a few per edge
+    const double width = (max_x - min_x) * std::cos(global::toRadians((min_y + max_y) / 2));
+    const double height = max_y - min_y;
+    const double target = std::clamp(double(edges.size() * ZONE_INDEX_CELLS_PER_EDGE), 1.0, double(ZONE_INDEX_MAX_CELLS));
+    if(width > 0.0 && height > 0.0) {
+        cols = std::clamp<std::size_t>(std::lround(std::sqrt(target * width / height)), 1, ZONE_INDEX_MAX_CELLS);
+        rows = std::max<std::size_t>(1, static_cast<std::size_t>(target) / cols);
+    } else {
+        rows = cols = 1;
+    }
+    cell_w = (max_x - min_x) / cols;
+    cell_h = (max_y - min_y) / rows;
+
+    std::vector<std::vector<std::uint32_t>> crossing(rows * cols), inside(rows * cols);
+
+    for(std::size_t i = 0; i < edges.size(); i++) { // In polygon order, so the lists are sorted by polygon
+        const Edge& e = edges[i];
+        const std::size_t c0 = cellIndex(std::min(e.x0, e.x1), min_x, cell_w, cols), c1 = cellIndex(std::max(e.x0, e.x1), min_x, cell_w, cols);
+        const std::size_t r0 = cellIndex(std::min(e.y0, e.y1), min_y, cell_h, rows), r1 = cellIndex(std::max(e.y0, e.y1), min_y, cell_h, rows);
+        for(std::size_t r = r0; r <= r1; r++) {
+            for(std::size_t c = c0; c <= c1; c++) {
+                const double x0 = min_x + c * cell_w, y0 = min_y + r * cell_h;
+                if(touchesBox(e.x0, e.y0, e.x1, e.y1, x0, y0, x0 + cell_w, y0 + cell_h))
+                    crossing[cell(r, c)].push_back(i);
+            }
+        }
+    }
+
+    // Cell centers inside each polygon, by crossings of a horizontal ray along each row of centers
+    #pragma omp parallel for schedule(dynamic) // parallelize over rows
+    for(std::size_t r = 0; r < rows; r++) {
+        const double cy = centerY(r);
+        std::vector<double> xs;
+        for(std::size_t p = 0; p < num_polygons; p++) {
+            xs.clear();
+            for(std::size_t i = polygon_start[p]; i < polygon_start[p + 1]; i++) {
+                const Edge& e = edges[i];
+                if((e.y0 > cy) != (e.y1 > cy))
+                    xs.push_back(e.x0 + (cy - e.y0) * (e.x1 - e.x0) / (e.y1 - e.y0));
+            }
+            std::sort(xs.begin(), xs.end());
+            std::size_t left = 0; // Crossings left of the center
+            for(std::size_t c = 0; c < cols; c++) {
+                const double cx = centerX(c);
+                while(left < xs.size() && xs[left] < cx) left++;
+                if(left % 2 == 1)
+                    inside[cell(r, c)].push_back(p);
+            }
+        }
+    }
+
+    compress(crossing, edge_start, cell_edges);
+    compress(inside, inside_start, cell_inside);
+};
+
+void ZoneIndex::boundaryPoints(const terrain::LatLngAlt& position, double lng_meters, double lat_meters, double offset, 
+                               std::vector<terrain::LatLngAlt>& points) const {
+    for(const Edge& e : edges) {
+        // Meters from the position
+        const double ax = (e.x0 - position.lng) * lng_meters, ay = (e.y0 - position.lat) * lat_meters;
+        const double dx = (e.x1 - e.x0) * lng_meters, dy = (e.y1 - e.y0) * lat_meters;
+        const double length = std::sqrt(dx * dx + dy * dy);
+        if(length <= 0.0) continue;
+        const double t = std::clamp(-(ax * dx + ay * dy) / (length * length), 0.0, 1.0);
+        const double px = ax + t * dx, py = ay + t * dy;
+        const double nx = -dy / length * offset, ny = dx / length * offset; // Normal to the edge
+        points.push_back({position.lat + (py + ny) / lat_meters, position.lng + (px + nx) / lng_meters, position.alt});
+        points.push_back({position.lat + (py - ny) / lat_meters, position.lng + (px - nx) / lng_meters, position.alt});
+    }
+};
+
+bool ZoneIndex::contains(const terrain::LatLngAlt& position) const {
+    const double x = position.lng, y = position.lat;
+    if(num_polygons == 0 || x < min_x || x > max_x || y < min_y || y > max_y)
+        return false;
+
+    const std::size_t r = cellIndex(y, min_y, cell_h, rows);
+    const std::size_t c = cellIndex(x, min_x, cell_w, cols);
+    const std::size_t k = cell(r, c);
+    const double cx = centerX(c), cy = centerY(r);
+
+    // For each polygon of the cell: inside if the center is, flipped by every edge between the center and the point
+    std::size_t i = inside_start[k], j = edge_start[k];
+    const std::size_t i_end = inside_start[k + 1], j_end = edge_start[k + 1];
+    while(i < i_end || j < j_end) {
+        const std::uint32_t p = std::min(i < i_end ? cell_inside[i] : UINT32_MAX, j < j_end ? edges[cell_edges[j]].polygon : UINT32_MAX);
+        bool in = false;
+        if(i < i_end && cell_inside[i] == p) {
+            in = true;
+            i++;
+        }
+        for(; j < j_end && edges[cell_edges[j]].polygon == p; j++) {
+            const Edge& e = edges[cell_edges[j]];
+            if(crosses(e.x0, e.y0, e.x1, e.y1, cx, cy, x, y))
+                in = !in;
+        }
+        if(in)
+            return true;
+    }
+    return false;
+};
+
+SiteConstraints::SiteConstraints(const std::vector<geojson::Feature>& features) : features(features) {
+    std::vector<geojson::Polygon> allowed_polygons, forbidden_polygons;
+    for(const auto& feature : features) {
+        const std::string type = detail::require_string(feature.properties, "type");
+        std::vector<geojson::Polygon>* target;
+        if(type == "allowed_zone") {
+            target = &allowed_polygons;
+        } else if(type == "forbidden_zone") {
+            target = &forbidden_polygons;
+        } else {
+            throw std::runtime_error("Invalid zone: unknown feature type '" + type + "'");
+        }
+
+        if(feature.geometry_type == geojson::POLYGON) {
+            target->push_back(std::get<geojson::Polygon>(feature.coords));
+        } else if(feature.geometry_type == geojson::MULTIPOLYGON) {
+            const auto& multi = std::get<geojson::MultiPolygon>(feature.coords);
+            target->insert(target->end(), multi.begin(), multi.end());
+        } else {
+            throw std::runtime_error("Invalid zone: only 'Polygon' and 'MultiPolygon' geometries are supported.");
+        }
+    }
+    allowed = ZoneIndex(allowed_polygons);
+    forbidden = ZoneIndex(forbidden_polygons);
+    if(empty())
+        return;
+
+    // Permitted positions are within the allowed zones, or around the forbidden ones if there are only forbidden zones
+    std::vector<double> bbox = allowed.empty() ? forbidden.getBoundingBox() : allowed.getBoundingBox();
+    if(allowed.empty()) {
+        const double pad_lng = (bbox[2] - bbox[0]) * 0.05, pad_lat = (bbox[3] - bbox[1]) * 0.05;
+        bbox = {bbox[0] - pad_lng, bbox[1] - pad_lat, bbox[2] + pad_lng, bbox[3] + pad_lat};
+    }
+
+    rows = cols = ZONE_SNAP_RESOLUTION;
+    min_lat = bbox[1];
+    min_lng = bbox[0];
+    lat_step = (bbox[3] - bbox[1]) / (rows - 1);
+    lng_step = (bbox[2] - bbox[0]) / (cols - 1);
+    row_meters = terrain::EARTH_RADIUS * global::toRadians(lat_step);
+    col_meters = terrain::EARTH_RADIUS * global::toRadians(lng_step) * std::cos(global::toRadians((bbox[1] + bbox[3]) / 2));
+
+    permitted.assign(rows * cols, 0);
+    #pragma omp parallel for schedule(static) // parallelize over rows
+    for(std::size_t r = 0; r < rows; r++) {
+        for(std::size_t c = 0; c < cols; c++)
+            permitted[r * cols + c] = permits({min_lat + r * lat_step, min_lng + c * lng_step, 0.0});
+    }
+};
+
+bool SiteConstraints::snap(terrain::LatLngAlt& position) const {
+    if(empty() || permits(position))
+        return true;
+
+    // Meters per degree at the raster latitude
+    const double lat_meters = lat_step > 0.0 ? row_meters / lat_step : 0.0;
+    const double lng_meters = lng_step > 0.0 ? col_meters / lng_step : 0.0;
+    auto distance = [&](std::size_t r, std::size_t c) {
+        const double dy = (min_lat + r * lat_step - position.lat) * lat_meters;
+        const double dx = (min_lng + c * lng_step - position.lng) * lng_meters;
+        return std::sqrt(dx * dx + dy * dy);
+    };
+
+    const std::size_t r0 = lat_step > 0.0 ? static_cast<std::size_t>(std::clamp(std::round((position.lat - min_lat) / lat_step), 0.0, double(rows - 1))) : 0;
+    const std::size_t c0 = lng_step > 0.0 ? static_cast<std::size_t>(std::clamp(std::round((position.lng - min_lng) / lng_step), 0.0, double(cols - 1))) : 0;
+    const double d0 = distance(r0, c0);
+    const double step = std::min(row_meters, col_meters);
+
+    // Rings of nodes around the closest one, until no node of the next ring can be closer than the best
+    double best = std::numeric_limits<double>::infinity();
+    std::size_t best_r = 0, best_c = 0;
+    auto visit = [&](std::size_t r, std::size_t c) {
+        if(!permitted[r * cols + c]) return;
+        const double d = distance(r, c);
+        if(d < best) {
+            best = d;
+            best_r = r;
+            best_c = c;
+        }
+    };
+    const std::size_t max_ring = std::max(rows, cols);
+    for(std::size_t k = 0; k <= max_ring; k++) {
+        if(k * step - d0 > best) break;
+        const std::size_t ra = r0 >= k ? r0 - k : 0, rb = std::min(rows - 1, r0 + k);
+        const std::size_t ca = c0 >= k ? c0 - k : 0, cb = std::min(cols - 1, c0 + k);
+        for(std::size_t r = ra; r <= rb; r++) {
+            if(r + k == r0 || r == r0 + k) { // Top and bottom sides
+                for(std::size_t c = ca; c <= cb; c++)
+                    visit(r, c);
+            } else { // Left and right sides
+                if(c0 >= k) visit(r, c0 - k);
+                if(k > 0 && c0 + k < cols) visit(r, c0 + k);
+            }
+        }
+    }
+
+    if(std::isinf(best))
+        return snapToBoundary(position);
+    position.lat = min_lat + best_r * lat_step;
+    position.lng = min_lng + best_c * lng_step;
+    return true;
+};
+
+bool SiteConstraints::snapToBoundary(terrain::LatLngAlt& position) const {
+    const double lat_meters = terrain::EARTH_RADIUS * global::toRadians(1.0);
+    const double lng_meters = lat_meters * std::cos(global::toRadians(position.lat));
+    std::vector<terrain::LatLngAlt> points;
+    allowed.boundaryPoints(position, lng_meters, lat_meters, ZONE_SNAP_EDGE_OFFSET, points);
+    forbidden.boundaryPoints(position, lng_meters, lat_meters, ZONE_SNAP_EDGE_OFFSET, points);
+
+    auto squaredDistance = [&](const terrain::LatLngAlt& p) {
+        const double dy = (p.lat - position.lat) * lat_meters, dx = (p.lng - position.lng) * lng_meters;
+        return dx * dx + dy * dy;
+    };
+    std::sort(points.begin(), points.end(), [&](const terrain::LatLngAlt& a, const terrain::LatLngAlt& b) { return squaredDistance(a) < squaredDistance(b); });
+    for(const auto& point : points) {
+        if(permits(point)) {
+            position.lat = point.lat;
+            position.lng = point.lng;
+            return true;
+        }
+    }
+    return false;
+};
+
+} // namespace zones